@@ -0,0 +1,207 @@
+#include "bench.hpp"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "pico/time.h"
+
+#include "types.hpp"
+#include "pens.hpp"
+#include "splash.hpp"
+#include "jimney.hpp"
+#include "environment.hpp"
+#include "inclinometer.hpp"
+#include "damage.hpp"
+#include "rgb565.hpp"
+#include "fusion.hpp"
+
+static const int MAX_SAMPLES = 2048;
+static uint32_t samplesNs[MAX_SAMPLES];
+
+BenchResult runBenchmark(const char* name, int samples, int batch, BenchFunction fn, void* context) {
+  if(samples > MAX_SAMPLES) samples = MAX_SAMPLES;
+  if(samples < 1) samples = 1;
+
+  // Warm caches and let the renderers settle before measuring
+  fn(context);
+
+  for(int i = 0; i < samples; i++) {
+    uint64_t start = time_us_64();
+    for(int j = 0; j < batch; j++) {
+      fn(context);
+    }
+    uint64_t elapsed = time_us_64() - start;
+    samplesNs[i] = (uint32_t)(elapsed * 1000 / batch);
+  }
+
+  std::sort(samplesNs, samplesNs + samples);
+
+  BenchResult result;
+  result.name = name;
+  result.samples = samples;
+  result.batch = batch;
+  result.minNs = samplesNs[0];
+  result.medianNs = samplesNs[samples / 2];
+  result.p99Ns = samplesNs[(samples * 99) / 100 < samples ? (samples * 99) / 100 : samples - 1];
+  result.maxNs = samplesNs[samples - 1];
+  return result;
+}
+
+void printBenchResult(const BenchResult& result) {
+  printf("{\"name\":\"%s\",\"samples\":%d,\"batch\":%d,\"min_ns\":%lu,\"median_ns\":%lu,\"p99_ns\":%lu,\"max_ns\":%lu}\n",
+    result.name, result.samples, result.batch,
+    (unsigned long)result.minNs, (unsigned long)result.medianNs,
+    (unsigned long)result.p99Ns, (unsigned long)result.maxNs);
+}
+
+struct RenderContext {
+  PicoGraphics_PenRGB332* graphics;
+  Pens pens;
+  uint8_t* previous;
+  uint16_t* converted;
+  int frame;
+};
+
+static void benchSplash(void* context) {
+  auto ctx = (RenderContext*)context;
+  renderSplashFrame(*ctx->graphics, ctx->pens);
+}
+
+static void benchEnvironment(void* context) {
+  auto ctx = (RenderContext*)context;
+
+  // Sweep the readings so the digits change like they do on the road
+  ctx->frame++;
+  EnvironmentSample sample;
+  sample.temperature = 20.0f + (ctx->frame % 40);
+  sample.pressure = 101325.0f;
+  sample.humidity = 30.0f + (ctx->frame % 50);
+  sample.gasResistance = 50000.0f;
+  sample.heatStable = true;
+
+  drawEnvironmentFrame(*ctx->graphics, ctx->pens, ctx->frame & 1 ? CELSIUS : FAHRENHEIT, sample);
+}
+
+static void benchInclinometer(void* context) {
+  auto ctx = (RenderContext*)context;
+  renderInclinometerFrame(*ctx->graphics, ctx->pens);
+}
+
+static void benchJimnyDark(void* context) {
+  auto ctx = (RenderContext*)context;
+  drawJimny(*ctx->graphics, 56, 56, DARK);
+}
+
+static void benchJimnyLight(void* context) {
+  auto ctx = (RenderContext*)context;
+  drawJimny(*ctx->graphics, 56, 40, LIGHT);
+}
+
+static volatile int32_t geometrySink;
+
+static void benchRotateLine(void* context) {
+  auto ctx = (RenderContext*)context;
+  ctx->frame++;
+  auto line = rotateLine(Line(Point(0, 120), Point(240, 120)), degreesToAngle(toQ16((ctx->frame % 21) - 10)));
+  geometrySink = line.p1.y + line.p2.y;
+}
+
+static void benchLineIntersection(void* context) {
+  auto ctx = (RenderContext*)context;
+  ctx->frame++;
+  int y = 100 + (ctx->frame % 40);
+  auto point = lineIntersection(Line(Point(0, y), Point(240, 240 - y)), Line(Point(0, 0), Point(0, 240)));
+  geometrySink = point.x + point.y;
+}
+
+static void benchFillHorizon(void* context) {
+  auto ctx = (RenderContext*)context;
+  ctx->frame++;
+  auto line = rotateLine(Line(Point(0, 120), Point(240, 120)), degreesToAngle(toQ16((ctx->frame % 61) - 30)));
+  fillHorizon(*ctx->graphics, line, ctx->pens.GRASS_GREEN_DAY, ctx->pens.SKY_BLUE_DAY);
+}
+
+static void benchAttitudeFilter(void* context) {
+  static AttitudeFilter filter(16393, 208783);
+  auto ctx = (RenderContext*)context;
+  ctx->frame++;
+
+  // Gently rocking, about 10° of roll and a little gyro noise
+  ImuReading reading = {{(int16_t)(ctx->frame & 63), 2846, 16144}, {(int16_t)((ctx->frame & 15) - 8), 3, -2}};
+  filter.update(reading, 5000);
+  geometrySink = filter.roll;
+}
+
+// An inclinometer frame at a given attitude, without needing the IMU to
+// report it
+static void drawAttitudeFrame(RenderContext& ctx, int pitch, int roll) {
+  auto line = rotateLine(Line(Point(0, 120 + pitch), Point(240, 120 + pitch)), degreesToAngle(toQ16(roll)));
+  fillHorizon(*ctx.graphics, line, ctx.pens.GRASS_GREEN_DAY, ctx.pens.SKY_BLUE_DAY);
+  drawJimny(*ctx.graphics, 56, 56, DARK);
+}
+
+static void benchConvertFrame(void* context) {
+  auto ctx = (RenderContext*)context;
+  auto pixels = (const uint8_t*)ctx->graphics->frame_buffer;
+  for(int y = 0; y < HEIGHT; y++) {
+    convertRGB332Span(pixels + y * WIDTH, ctx->converted, WIDTH);
+  }
+}
+
+static void benchDiffFrames(void* context) {
+  auto ctx = (RenderContext*)context;
+  Damage damage;
+  diffFrames(ctx->previous, (const uint8_t*)ctx->graphics->frame_buffer, damage);
+  geometrySink = damage.count;
+}
+
+void runRenderBenchmarks(const char* platform, int samples) {
+  static PicoGraphics_PenRGB332 graphics(WIDTH, HEIGHT, nullptr);
+  static uint8_t previous[WIDTH * HEIGHT];
+  static uint16_t converted[WIDTH];
+
+  RenderContext ctx;
+  ctx.graphics = &graphics;
+  ctx.pens = initGraphics(graphics);
+  ctx.previous = previous;
+  ctx.converted = converted;
+  ctx.frame = 0;
+
+  // No live sensors, every pass would start another set of sensor alarms
+  // and their interrupts would land in the timings. The screens are fed
+  // synthetic readings instead.
+
+  // Fill the history so the environment benchmark includes both graphs,
+  // once, a second pass would take the history's clock backwards
+  static bool historyFilled = false;
+  if(!historyFilled) {
+    for(uint32_t t = 0; t < 24 * 60 * 60; t += 10) {
+      EnvironmentSample sample = {25.0f + (t / 600) % 10, 101325.0f, 45.0f, 50000.0f, true};
+      recordEnvironmentSample(sample, t);
+    }
+    historyFilled = true;
+  }
+
+  printf("{\"suite\":\"jimneyio-render\",\"platform\":\"%s\",\"samples\":%d}\n", platform, samples);
+
+  printBenchResult(runBenchmark("renderSplashFrame", samples, 1, benchSplash, &ctx));
+  printBenchResult(runBenchmark("renderEnvironmentFrame", samples, 1, benchEnvironment, &ctx));
+  printBenchResult(runBenchmark("renderInclinometerFrame", samples, 1, benchInclinometer, &ctx));
+  printBenchResult(runBenchmark("drawJimny/dark", samples, 1, benchJimnyDark, &ctx));
+  printBenchResult(runBenchmark("drawJimny/light", samples, 1, benchJimnyLight, &ctx));
+  printBenchResult(runBenchmark("rotateLine", samples, 100, benchRotateLine, &ctx));
+  printBenchResult(runBenchmark("lineIntersection", samples, 100, benchLineIntersection, &ctx));
+  printBenchResult(runBenchmark("fillHorizon", samples, 1, benchFillHorizon, &ctx));
+  printBenchResult(runBenchmark("AttitudeFilter::update", samples, 100, benchAttitudeFilter, &ctx));
+
+  // Conversion and diffing cost depend only on the frame size. Diff two
+  // inclinometer frames a small tilt apart, the host stand-in's first step,
+  // so the rows around the horizon differ like they do on the road.
+  drawAttitudeFrame(ctx, 0, 0);
+  memcpy(previous, graphics.frame_buffer, sizeof(previous));
+  drawAttitudeFrame(ctx, 2, 1);
+
+  printBenchResult(runBenchmark("convertRGB332Frame", samples, 1, benchConvertFrame, &ctx));
+  printBenchResult(runBenchmark("diffFrames", samples, 1, benchDiffFrames, &ctx));
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+typedef void (*BenchFunction)(void* context);
+
+struct BenchResult {
+  const char* name;
+  int samples;
+  int batch;
+  uint32_t minNs;
+  uint32_t medianNs;
+  uint32_t p99Ns;
+  uint32_t maxNs;
+};
+
+// Times `samples` runs of `batch` back to back calls to fn, batching keeps
+// cheap functions well above the 1us timer resolution
+BenchResult runBenchmark(const char* name, int samples, int batch, BenchFunction fn, void* context);
+
+// One JSON object per line so results can be collected and compared
+// across releases
+void printBenchResult(const BenchResult& result);
+
+// Every screen renderer, drawJimny, the inclinometer geometry and the
+// display conversion, all fed with synthetic sensor data
+void runRenderBenchmarks(const char* platform, int samples);
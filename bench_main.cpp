@@ -0,0 +1,21 @@
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "bench.hpp"
+
+// Samples per benchmark, each renderer runs this many frames
+static const int BENCH_SAMPLES = 1000;
+
+int main() {
+  stdio_init_all();
+
+  // Give the USB host a moment to open the serial port
+  sleep_ms(3000);
+
+  while(true) {
+    runRenderBenchmarks("rp2040", BENCH_SAMPLES);
+    sleep_ms(10000);
+  }
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+#include "buttons.hpp"
+#include "spsc_queue.hpp"
+
+#include "pico/time.h"
+#include "hardware/gpio.h"
+
+static const uint32_t DEBOUNCE_US = 20 * 1000;
+static const uint32_t LONG_PRESS_US = 800 * 1000;
+static const uint32_t CHORD_WINDOW_US = 80 * 1000;
+
+static const uint BUTTON_PINS[] = {A, B, X, Y};
+static const int BUTTON_COUNT = sizeof(BUTTON_PINS) / sizeof(BUTTON_PINS[0]);
+
+struct ButtonState {
+  bool down;
+  uint32_t changedUs;
+  uint32_t pressedUs;
+  alarm_id_t longPressAlarm;
+};
+
+// Only touched from the GPIO and alarm interrupts, which share a priority
+// and so never interrupt each other
+static ButtonState buttons[BUTTON_COUNT];
+
+// Filled from the interrupts, drained by the main loop
+static SpscQueue<ButtonEvent, 16> buttonEvents;
+
+static void pushEvent(BUTTON_EVENT type, int index, uint32_t timeUs, uint8_t chord = 0) {
+  ButtonEvent event = {timeUs, type, (BUTTON)index, chord};
+  buttonEvents.push(event);
+}
+
+// Buttons pull the pin low
+static bool isDown(int index) {
+  return !gpio_get(BUTTON_PINS[index]);
+}
+
+static int64_t longPressAlarm(alarm_id_t id, void* userData) {
+  int index = (intptr_t)userData;
+  buttons[index].longPressAlarm = 0;
+  if(buttons[index].down) {
+    pushEvent(BUTTON_LONG_PRESS, index, time_us_32());
+  }
+  return 0;
+}
+
+static void changeState(int index, bool down, uint32_t now) {
+  ButtonState& button = buttons[index];
+  button.down = down;
+  button.changedUs = now;
+
+  if(!down) {
+    if(button.longPressAlarm > 0) {
+      cancel_alarm(button.longPressAlarm);
+      button.longPressAlarm = 0;
+    }
+    pushEvent(BUTTON_RELEASE, index, now);
+    return;
+  }
+
+  button.pressedUs = now;
+  pushEvent(BUTTON_PRESS, index, now);
+  button.longPressAlarm = add_alarm_in_us(LONG_PRESS_US, longPressAlarm, (void*)(intptr_t)index, true);
+
+  uint8_t held = 0;
+  bool together = true;
+  for(int i = 0; i < BUTTON_COUNT; i++) {
+    if(!buttons[i].down) continue;
+    held |= 1 << i;
+    together = together && now - buttons[i].pressedUs < CHORD_WINDOW_US;
+  }
+  if(together && (held & (held - 1))) {
+    pushEvent(BUTTON_CHORD, index, now, held);
+  }
+}
+
+// Catches whatever the pin settled on while edges were being ignored, a
+// press shorter than the debounce would otherwise never be released
+static int64_t settleAlarm(alarm_id_t id, void* userData) {
+  int index = (intptr_t)userData;
+  bool down = isDown(index);
+  if(down != buttons[index].down) {
+    changeState(index, down, time_us_32());
+  }
+  return 0;
+}
+
+// The first edge of a bounce counts straight away, the rest are ignored
+// until the contacts have had time to settle
+static void buttonInterrupt(uint gpio, uint32_t events) {
+  for(int index = 0; index < BUTTON_COUNT; index++) {
+    if(BUTTON_PINS[index] != gpio) continue;
+
+    uint32_t now = time_us_32();
+    if(now - buttons[index].changedUs < DEBOUNCE_US) return;
+
+    bool down = isDown(index);
+    if(down == buttons[index].down) return;
+
+    changeState(index, down, now);
+    add_alarm_in_us(DEBOUNCE_US, settleAlarm, (void*)(intptr_t)index, true);
+    return;
+  }
+}
+
+void initButtons() {
+  for(int index = 0; index < BUTTON_COUNT; index++) {
+    gpio_init(BUTTON_PINS[index]);
+    gpio_set_dir(BUTTON_PINS[index], GPIO_IN);
+    gpio_pull_up(BUTTON_PINS[index]);
+  }
+
+  uint32_t now = time_us_32();
+  for(int index = 0; index < BUTTON_COUNT; index++) {
+    // Anything held through boot isn't a press
+    buttons[index] = {isDown(index), now - DEBOUNCE_US, now, 0};
+    gpio_set_irq_enabled_with_callback(BUTTON_PINS[index], GPIO_IRQ_EDGE_FALL | GPIO_IRQ_EDGE_RISE, true, buttonInterrupt);
+  }
+}
+
+bool readButtonEvent(ButtonEvent& event) {
+  return buttonEvents.pop(event);
+}
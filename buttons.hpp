@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "types.hpp"
+
+// The four buttons on GPIO interrupts. Each edge is timestamped and
+// debounced in the interrupt, then queued for the main loop, so a press is
+// never missed however long a frame takes.
+
+enum BUTTON_EVENT {
+  BUTTON_PRESS,
+  BUTTON_RELEASE,
+  // Still held LONG_PRESS_US after the press
+  BUTTON_LONG_PRESS,
+  // Pressed while other buttons went down within CHORD_WINDOW_US of it
+  BUTTON_CHORD
+};
+
+struct ButtonEvent {
+  uint32_t timeUs;
+  BUTTON_EVENT type;
+  BUTTON button;
+  // Bit per BUTTON of everything held, set for BUTTON_CHORD
+  uint8_t chord;
+};
+
+// Claims the GPIO interrupt on the calling core
+void initButtons();
+
+// Oldest event not yet read, false when there isn't one
+bool readButtonEvent(ButtonEvent& event);
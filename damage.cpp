@@ -0,0 +1,83 @@
+#include "damage.hpp"
+
+#include <string.h>
+
+// Rows separated by fewer unchanged rows than this are sent as one window,
+// the CASET/RASET/RAMWR setup costs more than a few redundant rows
+static const int MERGE_GAP_ROWS = 4;
+
+static Rect unionOf(const Rect& a, const Rect& b) {
+  int32_t x1 = a.x < b.x ? a.x : b.x;
+  int32_t y1 = a.y < b.y ? a.y : b.y;
+  int32_t x2 = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+  int32_t y2 = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+  return Rect(x1, y1, x2 - x1, y2 - y1);
+}
+
+void Damage::clear() {
+  count = 0;
+}
+
+void Damage::add(const Rect& rect) {
+  if(rect.w <= 0 || rect.h <= 0) return;
+
+  if(count > 0) {
+    Rect& last = rects[count - 1];
+    if(rect.y - (last.y + last.h) < MERGE_GAP_ROWS || count == MAX_RECTS) {
+      last = unionOf(last, rect);
+      return;
+    }
+  }
+
+  rects[count++] = rect;
+}
+
+void Damage::addAll() {
+  count = 1;
+  rects[0] = Rect(0, 0, WIDTH, HEIGHT);
+}
+
+int Damage::area() const {
+  int total = 0;
+  for(int i = 0; i < count; i++) {
+    total += rects[i].w * rects[i].h;
+  }
+  return total;
+}
+
+void diffFrames(const uint8_t* previous, const uint8_t* next, Damage& damage) {
+  const int WORDS_PER_ROW = WIDTH / 4;
+
+  damage.clear();
+
+  int runStart = -1;
+  int runMinWord = WORDS_PER_ROW;
+  int runMaxWord = -1;
+
+  for(int y = 0; y <= HEIGHT; y++) {
+    bool changed = false;
+
+    if(y < HEIGHT && memcmp(previous + y * WIDTH, next + y * WIDTH, WIDTH) != 0) {
+      auto a = (const uint32_t*)(previous + y * WIDTH);
+      auto b = (const uint32_t*)(next + y * WIDTH);
+
+      int first = 0;
+      while(a[first] == b[first]) first++;
+
+      int last = WORDS_PER_ROW - 1;
+      while(a[last] == b[last]) last--;
+
+      if(runStart < 0) runStart = y;
+      if(first < runMinWord) runMinWord = first;
+      if(last > runMaxWord) runMaxWord = last;
+      changed = true;
+    }
+
+    if(!changed && runStart >= 0) {
+      damage.add(Rect(runMinWord * 4, runStart, (runMaxWord - runMinWord + 1) * 4, y - runStart));
+      runStart = -1;
+      runMinWord = WORDS_PER_ROW;
+      runMaxWord = -1;
+    }
+  }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "types.hpp"
+
+// Regions of a frame that differ from what is already on the panel.
+// Rects are added top to bottom and never overlap.
+struct Damage {
+  static const int MAX_RECTS = 8;
+
+  Rect rects[MAX_RECTS];
+  int count = 0;
+
+  void clear();
+  void add(const Rect& rect);
+  void addAll();
+
+  bool empty() const { return count == 0; }
+  int area() const;
+};
+
+// Compares two RGB332 framebuffers row by row and records the changed
+// columns of each run of changed rows.
+void diffFrames(const uint8_t* previous, const uint8_t* next, Damage& damage);
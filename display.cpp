@@ -0,0 +1,202 @@
+#include "display.hpp"
+#include "rgb565.hpp"
+
+#include "hardware/spi.h"
+#include "hardware/gpio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "drivers/st7789/st7789.hpp"
+
+// ST7789 commands used for windowed writes, the panel itself is
+// initialised by the pimoroni driver
+static const uint8_t CASET = 0x2A;
+static const uint8_t RASET = 0x2B;
+static const uint8_t RAMWR = 0x2C;
+
+// 240x240 panel in ROTATE_90 maps straight onto the controller RAM
+static const int COL_OFFSET = 0;
+static const int ROW_OFFSET = 0;
+
+// What the pimoroni driver sets the bus to, 16ns between rising edges is
+// the fastest the panel takes. A slower clk_peri gets as close as it can.
+static const uint32_t SPI_BAUD = 62500000;
+
+// Two scanlines per block keeps conversion well inside one block's
+// transfer time while keeping the interrupt rate low
+static const int BLOCK_PIXELS = WIDTH * 2;
+
+struct Block {
+  uint16_t pixels[BLOCK_PIXELS];
+  size_t length;
+  bool startsWindow;
+  Rect window;
+};
+
+static SPIPins pins;
+static int dmaChannel = -1;
+
+static Block blocks[2];
+static int sendingBlock = 0;
+
+static const uint8_t* frameBuffer = nullptr;
+static const Damage* frameDamage = nullptr;
+static int nextRect = 0;
+static int nextRow = 0;
+
+static DisplayCallback completeCallback = nullptr;
+static void* completeContext = nullptr;
+static volatile bool busy = false;
+
+static void command(uint8_t cmd, size_t len = 0, const uint8_t* data = nullptr) {
+  gpio_put(pins.dc, 0);
+  gpio_put(pins.cs, 0);
+  spi_write_blocking(pins.spi, &cmd, 1);
+  if(len > 0) {
+    gpio_put(pins.dc, 1);
+    spi_write_blocking(pins.spi, data, len);
+  }
+  gpio_put(pins.cs, 1);
+}
+
+static void setWindow(const Rect& rect) {
+  uint16_t x1 = rect.x + COL_OFFSET;
+  uint16_t x2 = rect.x + rect.w - 1 + COL_OFFSET;
+  uint16_t y1 = rect.y + ROW_OFFSET;
+  uint16_t y2 = rect.y + rect.h - 1 + ROW_OFFSET;
+
+  uint8_t caset[4] = {(uint8_t)(x1 >> 8), (uint8_t)x1, (uint8_t)(x2 >> 8), (uint8_t)x2};
+  uint8_t raset[4] = {(uint8_t)(y1 >> 8), (uint8_t)y1, (uint8_t)(y2 >> 8), (uint8_t)y2};
+  command(CASET, 4, caset);
+  command(RASET, 4, raset);
+}
+
+// DMA completion only means the last byte reached the SPI FIFO
+static void waitForSpiIdle() {
+  while(spi_is_busy(pins.spi)) {
+    tight_loop_contents();
+  }
+}
+
+// Converts the next rows of the current damage rect into block, returns
+// false once every rect has been consumed
+static bool prepareBlock(Block& block) {
+  if(nextRect >= frameDamage->count) {
+    block.length = 0;
+    return false;
+  }
+
+  const Rect& rect = frameDamage->rects[nextRect];
+  block.startsWindow = nextRow == 0;
+  block.window = rect;
+
+  int rows = BLOCK_PIXELS / rect.w;
+  if(rows > rect.h - nextRow) rows = rect.h - nextRow;
+
+  uint16_t* out = block.pixels;
+  for(int i = 0; i < rows; i++) {
+    convertRGB332Span(frameBuffer + (rect.y + nextRow + i) * WIDTH + rect.x, out, rect.w);
+    out += rect.w;
+  }
+  block.length = rows * rect.w * sizeof(uint16_t);
+
+  nextRow += rows;
+  if(nextRow >= rect.h) {
+    nextRect++;
+    nextRow = 0;
+  }
+  return true;
+}
+
+static void sendBlock(const Block& block) {
+  if(block.startsWindow) {
+    waitForSpiIdle();
+    gpio_put(pins.cs, 1);
+    setWindow(block.window);
+
+    gpio_put(pins.dc, 0);
+    gpio_put(pins.cs, 0);
+    spi_write_blocking(pins.spi, &RAMWR, 1);
+    gpio_put(pins.dc, 1);
+  }
+
+  dma_channel_transfer_from_buffer_now(dmaChannel, block.pixels, block.length);
+}
+
+static void finishFrame() {
+  waitForSpiIdle();
+  gpio_put(pins.cs, 1);
+  busy = false;
+
+  if(completeCallback) {
+    completeCallback(completeContext);
+  }
+}
+
+static void dmaIrqHandler() {
+  if(!dma_channel_get_irq1_status(dmaChannel)) return;
+  dma_channel_acknowledge_irq1(dmaChannel);
+
+  // Get the already converted block on the wire first, then refill the
+  // block that just finished while it transfers
+  int finished = sendingBlock;
+  int next = finished ^ 1;
+
+  if(blocks[next].length == 0) {
+    finishFrame();
+    return;
+  }
+
+  sendingBlock = next;
+  sendBlock(blocks[next]);
+  prepareBlock(blocks[finished]);
+}
+
+void initDisplay() {
+  pins = get_spi_pins(BG_SPI_FRONT);
+
+  dmaChannel = dma_claim_unused_channel(true);
+  dma_channel_config config = dma_channel_get_default_config(dmaChannel);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+  channel_config_set_dreq(&config, spi_get_dreq(pins.spi, true));
+  channel_config_set_read_increment(&config, true);
+  channel_config_set_write_increment(&config, false);
+  dma_channel_configure(dmaChannel, &config, &spi_get_hw(pins.spi)->dr, nullptr, 0, false);
+
+  dma_channel_set_irq1_enabled(dmaChannel, true);
+  irq_add_shared_handler(DMA_IRQ_1, dmaIrqHandler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_1, true);
+}
+
+void applyDisplayClock() {
+  spi_set_baudrate(pins.spi, SPI_BAUD);
+}
+
+void updateDisplay(PicoGraphics_PenRGB332& graphics, const Damage& damage, DisplayCallback onComplete, void* context) {
+  frameBuffer = (const uint8_t*)graphics.frame_buffer;
+  frameDamage = &damage;
+  nextRect = 0;
+  nextRow = 0;
+  completeCallback = onComplete;
+  completeContext = context;
+
+  if(!prepareBlock(blocks[0])) {
+    if(onComplete) {
+      onComplete(context);
+    }
+    return;
+  }
+
+  busy = true;
+  sendingBlock = 0;
+
+  // The interrupt can't run on this core until both blocks are set up
+  uint32_t interrupts = save_and_disable_interrupts();
+  sendBlock(blocks[0]);
+  prepareBlock(blocks[1]);
+  restore_interrupts(interrupts);
+}
+
+bool isDisplayBusy() {
+  return busy;
+}
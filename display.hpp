@@ -0,0 +1,23 @@
+#pragma once
+
+#include "types.hpp"
+#include "damage.hpp"
+
+typedef void (*DisplayCallback)(void* context);
+
+// Claims the DMA channel and installs its interrupt on the calling core,
+// which is the core that will service the transfer
+void initDisplay();
+
+// Starts sending the damaged windows of the framebuffer to the panel and
+// returns straight away. RGB332 -> RGB565 conversion of each block happens
+// in the DMA interrupt while the previous block is on the wire, and
+// onComplete is called from the interrupt once the last pixel has gone.
+// The framebuffer and damage must not change until then.
+void updateDisplay(PicoGraphics_PenRGB332& graphics, const Damage& damage, DisplayCallback onComplete, void* context);
+
+bool isDisplayBusy();
+
+// The SPI divider is worked out from clk_peri, call after changing the
+// system clock while no frame is being sent
+void applyDisplayClock();
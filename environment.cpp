@@ -1,22 +1,22 @@
 #include "environment.hpp"
-#include "drivers/bme68x/bme68x.hpp"
-#include "common/pimoroni_i2c.hpp"
-
-I2C i2c(BOARD::BREAKOUT_GARDEN);
-BME68X bme68x(&i2c, BME68X::ALTERNATE_I2C_ADDRESS);
+#include "sensors.hpp"
+#include "fixed.hpp"
+#include "history.hpp"
+#include "recording.hpp"
 
 const float MIN_GAS = 100000.0;
 const float MAX_GAS = 0.0;
 const int ALTITUDE = 0;
 
-std::vector<Point> waterDrop;
+// Built once by the static constructors, polygon() only takes a vector
+const std::vector<Point> waterDrop = {
+  Point(19, 215),
+  Point(25, 205),
+  Point(31, 215),
+};
 
 void initEnvironment() {
-  bme68x.init();
-
-  waterDrop.push_back(Point(19, 215));
-  waterDrop.push_back(Point(25, 205));
-  waterDrop.push_back(Point(31, 215));
+  initEnvironmentSensor();
 }
 
 float adjustToSeaPressure(float pressureHpa, float temperature, float altitude) {
@@ -27,35 +27,122 @@ float adjustToSeaPressure(float pressureHpa, float temperature, float altitude)
   return pressureHpa + ((pressureHpa * 9.80665 * altitude) / (287 * (273 + temperature + (altitude / 400))));
 }
 
+// Most recent reading, redrawn every frame until the next one lands
+EnvironmentSample latestSample = {0.0f, 0.0f, 0.0f, 0.0f, false};
+
+// Corrected temperature in °C for the last hour and day
+HistorySeries temperatureHistory;
+
+// The sensor sits next to the Pico and reads warm
+const q16 TEMPERATURE_OFFSET = toQ16(9);
+
+static q16 correctTemperature(q16 temperature) {
+  return temperature - TEMPERATURE_OFFSET;
+}
+
+static q16 toFahrenheit(q16 celsius) {
+  return (celsius * 9 / 5) + toQ16(32);
+}
+
+void recordEnvironmentSample(const EnvironmentSample& sample, uint32_t seconds) {
+  latestSample = sample;
+
+  if(sample.heatStable) {
+    temperatureHistory.add(correctTemperature(toQ16(sample.temperature)), seconds);
+  }
+}
+
+bool updateEnvironment(uint32_t seconds) {
+  bool updated = false;
+  EnvironmentSample sample;
+  while(readEnvironmentSample(sample)) {
+    recordEnvironment(sample);
+    recordEnvironmentSample(sample, seconds);
+    updated = true;
+  }
+  return updated;
+}
+
 void renderEnvironmentFrame(PicoGraphics& graphics, Pens& pens, UNIT units) {
-  const int TEMPERATURE_OFFSET = 9;
+  drawEnvironmentFrame(graphics, pens, units, latestSample);
+}
+
+const int32_t GRAPH_Y = 18;
+const int32_t GRAPH_HEIGHT = 36;
+const int32_t GRAPH_COLUMN_WIDTH = 2;
+
+// Label with average and range, then one bar per bucket from its min to max
+static void drawHistoryGraph(PicoGraphics& graphics, Pens& pens, UNIT units, HISTORY_TIER tier, int32_t x, const char* label) {
+  HistoryBucket stats = temperatureHistory.stats(tier);
+  char buffer[32];
+
+  graphics.set_pen(pens.WHITE);
+  if(stats.count == 0) {
+    snprintf(buffer, sizeof(buffer), "%s --", label);
+    graphics.text(buffer, Point(x, 4), WIDTH, 1);
+    return;
+  }
 
-  bme68x_data data;
-  auto result = bme68x.read_forced(&data, 300, 100);
-  (void)result;
-  
+  q16 average = stats.average(), low = stats.min, high = stats.max;
+  if(units == FAHRENHEIT) {
+    average = toFahrenheit(average);
+    low = toFahrenheit(low);
+    high = toFahrenheit(high);
+  }
+  snprintf(buffer, sizeof(buffer), "%s %d (%d-%d)", label, (int)q16ToInt(average), (int)q16ToInt(low), (int)q16ToInt(high));
+  graphics.text(buffer, Point(x, 4), WIDTH, 1);
+
+  // Keep a steady reading from filling the graph with noise
+  q16 bottom = stats.min, top = stats.max;
+  if(top - bottom < Q16_ONE) {
+    bottom = (bottom + top) / 2 - Q16_HALF;
+    top = bottom + Q16_ONE;
+  }
+  int64_t range = top - bottom;
+
+  graphics.set_pen(pens.LIGHT_BLUE);
+  const HistoryTier& history = temperatureHistory.tiers[tier];
+  HistoryBucket newest = temperatureHistory.newest(tier);
+  for(int i = 0; i <= HISTORY_BUCKETS; i++) {
+    const HistoryBucket& bucket = i < HISTORY_BUCKETS ? history.bucket(i) : newest;
+    if(bucket.count == 0) continue;
+
+    int32_t y1 = GRAPH_Y + (int32_t)((top - bucket.max) * (GRAPH_HEIGHT - 1) / range);
+    int32_t y2 = GRAPH_Y + (int32_t)((top - bucket.min) * (GRAPH_HEIGHT - 1) / range);
+    graphics.rectangle(Rect(x + i * GRAPH_COLUMN_WIDTH, y1, GRAPH_COLUMN_WIDTH, y2 - y1 + 1));
+  }
+}
+
+void drawEnvironmentFrame(PicoGraphics& graphics, Pens& pens, UNIT units, const EnvironmentSample& data) {
   graphics.set_pen(pens.BLACK);
   graphics.clear();
 
-  auto correctedTemperature = data.temperature - TEMPERATURE_OFFSET;
-  auto dewpoint = data.temperature - ((100 - data.humidity) / 5);
-  auto correctedHumidity = 100 - (5 * (correctedTemperature - dewpoint));
-  auto correctedTemperatureF = (correctedTemperature * 9/5)+32;
+  drawHistoryGraph(graphics, pens, units, HISTORY_HOUR, 14, "1H");
+  drawHistoryGraph(graphics, pens, units, HISTORY_DAY, 128, "24H");
+
+  // One float conversion per reading, the rest is integer maths
+  q16 temperature = toQ16(data.temperature);
+  q16 humidity = toQ16(data.humidity);
+
+  q16 correctedTemperature = correctTemperature(temperature);
+  q16 dewpoint = temperature - ((toQ16(100) - humidity) / 5);
+  q16 correctedHumidity = toQ16(100) - (5 * (correctedTemperature - dewpoint));
+  q16 correctedTemperatureF = toFahrenheit(correctedTemperature);
 
-  // auto gas = MAX(MIN(MAX_GAS, data.gas_resistance), MIN_GAS);
+  // auto gas = MAX(MIN(MAX_GAS, data.gasResistance), MIN_GAS);
   // auto pressureHpa = adjustToSeaPressure(data.pressure / 100, data.temperature, ALTITUDE);
 
-  if(data.status & BME68X_HEAT_STAB_MSK) 
+  if(data.heatStable) 
   {        
     char primaryBuffer[16], secondaryBuffer[16];
 
     if(units == CELSIUS) {
-      snprintf(primaryBuffer, sizeof(primaryBuffer), "%.0f°C", correctedTemperature);
-      snprintf(secondaryBuffer, sizeof(secondaryBuffer), "%.0f°F", correctedTemperatureF);
+      snprintf(primaryBuffer, sizeof(primaryBuffer), "%d°C", (int)q16ToInt(correctedTemperature));
+      snprintf(secondaryBuffer, sizeof(secondaryBuffer), "%d°F", (int)q16ToInt(correctedTemperatureF));
     }
     else {
-      snprintf(primaryBuffer, sizeof(primaryBuffer), "%.0f°F", correctedTemperatureF);
-      snprintf(secondaryBuffer, sizeof(secondaryBuffer), "%.0f°C", correctedTemperature);
+      snprintf(primaryBuffer, sizeof(primaryBuffer), "%d°F", (int)q16ToInt(correctedTemperatureF));
+      snprintf(secondaryBuffer, sizeof(secondaryBuffer), "%d°C", (int)q16ToInt(correctedTemperature));
     }
 
     uint16_t primaryTextWidth = graphics.measure_text(primaryBuffer, 8) - 8;
@@ -69,7 +156,7 @@ void renderEnvironmentFrame(PicoGraphics& graphics, Pens& pens, UNIT units) {
     graphics.set_pen(pens.WHITE);
     graphics.text(secondaryBuffer, Point(centeredSecondaryTextX, 205), false, 3);
 
-    snprintf(primaryBuffer, sizeof(primaryBuffer), "%.0f%%", correctedHumidity);
+    snprintf(primaryBuffer, sizeof(primaryBuffer), "%d%%", (int)q16ToInt(correctedHumidity));
     graphics.text(primaryBuffer, Point(42, 205), false, 3);
 
     graphics.set_pen(pens.LIGHT_BLUE);
@@ -1,5 +1,20 @@
 #pragma once
 
 #include "types.hpp"
+#include "sensors.hpp"
+
 void initEnvironment();
-void renderEnvironmentFrame(PicoGraphics& graphics, Pens& pens, UNIT units);
\ No newline at end of file
+
+// Takes any new sensor samples into the history, run every loop so the
+// history keeps filling while other screens are up. `seconds` is the
+// history's clock. True if anything new came in, which is the only time
+// the environment screen changes.
+bool updateEnvironment(uint32_t seconds);
+
+// Makes `sample` the current reading and adds it to the history
+void recordEnvironmentSample(const EnvironmentSample& sample, uint32_t seconds);
+
+void renderEnvironmentFrame(PicoGraphics& graphics, Pens& pens, UNIT units);
+
+// Draws a given sample and the current history without touching the sensor
+void drawEnvironmentFrame(PicoGraphics& graphics, Pens& pens, UNIT units, const EnvironmentSample& data);
\ No newline at end of file
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed-point helpers, the RP2040 has no FPU so float and double maths is
+// all done in software.
+//
+//   q16      signed 16.16, general purpose values
+//   q15      signed 1.15, sine/cosine results
+//   angle16  unsigned binary angle, 65536 per turn so it wraps for free
+//   angle32  the same with 16 more bits for accumulating small steps
+
+typedef int32_t q16;
+typedef int16_t q15;
+typedef uint16_t angle16;
+typedef uint32_t angle32;
+
+static constexpr q16 Q16_ONE = 1 << 16;
+static constexpr q16 Q16_HALF = 1 << 15;
+static constexpr q15 Q15_ONE = 0x7FFF;
+
+static constexpr angle16 ANGLE_QUARTER = 0x4000;
+
+constexpr q16 toQ16(int32_t value) {
+  return value * Q16_ONE;
+}
+
+constexpr q16 toQ16(float value) {
+  return (q16)(value * Q16_ONE + (value < 0 ? -0.5f : 0.5f));
+}
+
+// Rounds to the nearest integer, halves round up
+constexpr int32_t q16ToInt(q16 value) {
+  return (value + Q16_HALF) >> 16;
+}
+
+constexpr float q16ToFloat(q16 value) {
+  return (float)value / Q16_ONE;
+}
+
+constexpr q16 q16Mul(q16 a, q16 b) {
+  return (q16)(((int64_t)a * b) >> 16);
+}
+
+constexpr q16 q16Div(q16 a, q16 b) {
+  return (q16)(((int64_t)a * Q16_ONE) / b);
+}
+
+constexpr angle16 degreesToAngle(q16 degrees) {
+  return (angle16)(((int64_t)degrees * 65536 / 360) >> 16);
+}
+
+constexpr q16 angleToDegrees(angle16 a) {
+  return (q16)(((int64_t)(int16_t)a * 360 * Q16_ONE) >> 16);
+}
+
+constexpr angle16 toAngle16(angle32 a) {
+  return (angle16)((a + 0x8000) >> 16);
+}
+
+// Integer square root, rounded down
+constexpr uint32_t isqrt(uint32_t value) {
+  uint32_t result = 0;
+  uint32_t bit = 1u << 30;
+  while(bit > value) bit >>= 2;
+
+  while(bit) {
+    if(value >= result + bit) {
+      value -= result + bit;
+      result = (result >> 1) + bit;
+    } else {
+      result >>= 1;
+    }
+    bit >>= 2;
+  }
+  return result;
+}
+
+// Angle of the vector (x, y) from the x axis, to within 0.1°. Uses
+// atan(z) ~ pi/4 z + z(1 - z)(0.2447 + 0.0663z) on the first octant.
+constexpr angle16 atan2Angle(int32_t y, int32_t x) {
+  if(x == 0 && y == 0) return 0;
+
+  uint32_t ax = x < 0 ? -(uint32_t)x : x;
+  uint32_t ay = y < 0 ? -(uint32_t)y : y;
+  bool steep = ay > ax;
+
+  // Ratio of the shorter side to the longer in q15, 0 to 1
+  int32_t z = steep ? (int32_t)(((uint64_t)ax << 15) / ay) : (int32_t)(((uint64_t)ay << 15) / ax);
+
+  // pi/4 is an eighth of a turn, 8192. The correction term is in q15
+  // radians, 10430 is 65536 / 2pi.
+  int32_t correction = (int32_t)(((int64_t)z * (32768 - z)) >> 15);
+  correction = (int32_t)(((int64_t)correction * (8018 + ((2173 * z) >> 15))) >> 15);
+  int32_t a = (z >> 2) + ((correction * 10430) >> 15);
+
+  if(steep) a = ANGLE_QUARTER - a;
+  if(x < 0) a = 2 * ANGLE_QUARTER - a;
+  if(y < 0) a = -a;
+  return (angle16)a;
+}
+
+// Quarter-wave sine table, entry i is sin(i/256 * 90°) in q15. Built at
+// compile time so it lives in flash.
+struct SineTable {
+  static const int SIZE = 256;
+  q15 values[SIZE + 1];
+
+  constexpr SineTable() : values() {
+    const double HALF_PI = 1.57079632679489661923;
+    for(int i = 0; i <= SIZE; i++) {
+      double x = HALF_PI * i / SIZE;
+
+      // Taylor series, plenty of terms for |x| <= pi/2
+      double term = x;
+      double sum = x;
+      for(int n = 1; n < 12; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+      }
+
+      values[i] = (q15)(sum * Q15_ONE + 0.5);
+    }
+  }
+};
+
+// inline so every file shares the one copy rather than each getting its own
+inline constexpr SineTable SINE_TABLE = SineTable();
+
+// sin of a binary angle, interpolated between table entries
+constexpr q15 sinQ15(angle16 a) {
+  int quadrant = a >> 14;
+  int offset = a & (ANGLE_QUARTER - 1);
+  if(quadrant & 1) offset = ANGLE_QUARTER - offset;
+
+  int index = offset >> 6;
+  int fraction = offset & 63;
+  int32_t value = SINE_TABLE.values[index];
+  if(fraction) {
+    value += ((SINE_TABLE.values[index + 1] - value) * fraction) >> 6;
+  }
+
+  return (q15)(quadrant & 2 ? -value : value);
+}
+
+constexpr q15 cosQ15(angle16 a) {
+  return sinQ15((angle16)(a + ANGLE_QUARTER));
+}
+
+constexpr int32_t q15Mul(int32_t value, q15 factor) {
+  return (value * factor) >> 15;
+}
+
+// Exponential moving average, alpha is the weight of the new sample
+constexpr q16 emaUpdate(q16 average, q16 sample, q16 alpha) {
+  return average + q16Mul(sample - average, alpha);
+}
@@ -0,0 +1,46 @@
+#include "flash_backend.hpp"
+
+#include <string.h>
+
+#include "pico.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+
+static const uint32_t FLASH_OPERATION_TIMEOUT_MS = 500;
+
+struct FlashOperation {
+  uint32_t offset;
+  const uint8_t* page;
+};
+
+static void eraseSector(void* param) {
+  auto operation = (FlashOperation*)param;
+  flash_range_erase(operation->offset, FLASH_SECTOR_SIZE);
+}
+
+static void programPage(void* param) {
+  auto operation = (FlashOperation*)param;
+  flash_range_program(operation->offset, operation->page, FLASH_PAGE_SIZE);
+}
+
+const uint8_t* PicoFlashBackend::read(uint32_t offset) {
+  return (const uint8_t*)(XIP_BASE + flashOffset + offset);
+}
+
+bool PicoFlashBackend::erase(uint32_t offset) {
+  FlashOperation operation = {flashOffset + offset, nullptr};
+  lastError = flash_safe_execute(eraseSector, &operation, FLASH_OPERATION_TIMEOUT_MS);
+  return lastError == PICO_OK;
+}
+
+bool PicoFlashBackend::program(uint32_t offset, const uint8_t* data, size_t length) {
+  // The flash only takes whole pages, 0xFF leaves the rest of it untouched
+  uint8_t page[FLASH_PAGE_SIZE];
+  uint32_t pageStart = offset - offset % FLASH_PAGE_SIZE;
+  memset(page, 0xFF, sizeof(page));
+  memcpy(page + (offset - pageStart), data, length);
+
+  FlashOperation operation = {flashOffset + pageStart, page};
+  lastError = flash_safe_execute(programPage, &operation, FLASH_OPERATION_TIMEOUT_MS);
+  return lastError == PICO_OK;
+}
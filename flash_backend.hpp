@@ -0,0 +1,21 @@
+#pragma once
+
+#include "kvstore.hpp"
+
+// A region of the Pico's own flash, read through XIP. Erase and program
+// run under flash_safe_execute so core1 is parked while flash is busy.
+class PicoFlashBackend : public FlashBackend {
+public:
+  // Offset of the region from the start of flash, sector aligned
+  PicoFlashBackend(uint32_t flashOffset) : flashOffset(flashOffset) {}
+
+  const uint8_t* read(uint32_t offset) override;
+  bool erase(uint32_t offset) override;
+  bool program(uint32_t offset, const uint8_t* data, size_t length) override;
+
+  // Result of the last flash_safe_execute, PICO_OK on success
+  int lastError = 0;
+
+private:
+  uint32_t flashOffset;
+};
@@ -0,0 +1,65 @@
+#include "fusion.hpp"
+
+// Samples averaged for the gyro bias before integrating
+static const int CALIBRATION_SAMPLES = 128;
+
+// Covers the gyro's turn-on time when the IMU has been powered down
+static const int SEED_SAMPLES = 16;
+
+// Each sample moves 1/64 of the way to the accelerometer angle, about a
+// 0.3s time constant at 200Hz
+static const int ACCEL_SHIFT = 6;
+
+// Bumps, braking and cornering add to gravity. Only trust the
+// accelerometer while the total is within 20% of 1g.
+static const int ACCEL_TOLERANCE_PERCENT = 20;
+
+void AttitudeFilter::update(const ImuReading& reading, uint32_t dtUs) {
+  int32_t ax = reading.accel[0];
+  int32_t ay = reading.accel[1];
+  int32_t az = reading.accel[2];
+
+  // Roll right side down and pitch nose up are positive, nose up is a
+  // negative turn about y
+  angle32 accelRoll = (angle32)atan2Angle(ay, az) << 16;
+  angle32 accelPitch = (angle32)atan2Angle(ax, isqrt((uint32_t)(ay * ay) + (uint32_t)(az * az))) << 16;
+
+  if(calibrationSamples < CALIBRATION_SAMPLES) {
+    calibrationSum[0] += reading.gyro[0];
+    calibrationSum[1] += reading.gyro[1];
+    calibrationSamples++;
+    if(calibrationSamples == CALIBRATION_SAMPLES) {
+      gyroBias[0] = calibrationSum[0] / CALIBRATION_SAMPLES;
+      gyroBias[1] = calibrationSum[1] / CALIBRATION_SAMPLES;
+    }
+
+    roll = accelRoll;
+    pitch = accelPitch;
+    return;
+  }
+
+  if(seedSamples > 0) {
+    seedSamples--;
+    roll = accelRoll;
+    pitch = accelPitch;
+    return;
+  }
+
+  roll += (angle32)(((int64_t)(reading.gyro[0] - gyroBias[0]) * gyroScale * dtUs) / 1000000);
+  pitch -= (angle32)(((int64_t)(reading.gyro[1] - gyroBias[1]) * gyroScale * dtUs) / 1000000);
+
+  uint64_t magnitude = (uint64_t)(ax * ax) + (uint64_t)(ay * ay) + (uint64_t)(az * az);
+  uint64_t oneG = (uint64_t)accelOneG * accelOneG;
+  uint64_t low = oneG * (100 - ACCEL_TOLERANCE_PERCENT) * (100 - ACCEL_TOLERANCE_PERCENT) / 10000;
+  uint64_t high = oneG * (100 + ACCEL_TOLERANCE_PERCENT) * (100 + ACCEL_TOLERANCE_PERCENT) / 10000;
+
+  // Differences wrap, so the blend takes the short way round
+  if(magnitude >= low && magnitude <= high) {
+    roll += (int32_t)(accelRoll - roll) >> ACCEL_SHIFT;
+    pitch += (int32_t)(accelPitch - pitch) >> ACCEL_SHIFT;
+  }
+}
+
+void AttitudeFilter::reseed() {
+  seedSamples = SEED_SAMPLES;
+}
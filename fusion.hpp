@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "fixed.hpp"
+
+// Raw counts straight from the IMU, x forward, y left, z up
+struct ImuReading {
+  int16_t accel[3];
+  int16_t gyro[3];
+};
+
+// Complementary filter: integrates the gyro for a fast, smooth attitude and
+// pulls it slowly towards the accelerometer's idea of down to cancel drift.
+struct AttitudeFilter {
+  // Scales of the configured sensor ranges
+  int32_t accelOneG;
+  int32_t gyroScale; // angle32 per second per count
+
+  angle32 pitch = 0;
+  angle32 roll = 0;
+
+  // Gyro zero offset, averaged over the first samples with the car parked
+  int32_t gyroBias[2] = {0, 0};
+  int32_t calibrationSum[2] = {0, 0};
+  int calibrationSamples = 0;
+
+  // Samples left that take the attitude straight from the accelerometer
+  int seedSamples = 0;
+
+  AttitudeFilter(int32_t accelOneG, int32_t gyroScale) : accelOneG(accelOneG), gyroScale(gyroScale) {}
+
+  void update(const ImuReading& reading, uint32_t dtUs);
+
+  // Starts again from the accelerometer after a gap in the readings, the
+  // gyro bias is kept
+  void reseed();
+};
@@ -0,0 +1,77 @@
+#include "heap.hpp"
+
+#include <new>
+#include <cstdlib>
+#include <malloc.h>
+
+#include "pico.h"
+
+static volatile uint32_t allocationCount = 0;
+static volatile bool heapSealed = false;
+static uint32_t sealedFreeHeap = 0;
+
+uint32_t getTotalHeap(void) {
+  extern char __StackLimit, __bss_end__;
+  return &__StackLimit  - &__bss_end__;
+}
+
+uint32_t getFreeHeap(void) {
+  struct mallinfo m = mallinfo();
+  return getTotalHeap() - m.uordblks;
+}
+
+uint32_t getAllocationCount() {
+  return allocationCount;
+}
+
+void sealHeap() {
+  sealedFreeHeap = getFreeHeap();
+  heapSealed = true;
+}
+
+bool isHeapSealed() {
+  return heapSealed;
+}
+
+uint32_t getSealedFreeHeap() {
+  return sealedFreeHeap;
+}
+
+static void* countedAlloc(std::size_t n) {
+  allocationCount++;
+
+#if HEAP_CHECK
+  if(heapSealed) {
+    // panic() prints, don't come back here if that allocates
+    heapSealed = false;
+    panic("heap allocation of %u bytes after init", (unsigned)n);
+  }
+#endif
+
+  return std::malloc(n);
+}
+
+// Replaces the pico SDK's new_delete.cpp, see PICO_CXX_DISABLE_ALLOCATION_OVERRIDES
+void* operator new(std::size_t n) {
+  return countedAlloc(n);
+}
+
+void* operator new[](std::size_t n) {
+  return countedAlloc(n);
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+  std::free(p);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdint.h>
+
+// Every operator new/delete in the firmware goes through heap.cpp so the
+// steady-state loop can be shown never to touch the heap.
+
+uint32_t getTotalHeap();
+
+// Walks the whole allocator through mallinfo(), keep it out of the frame loop
+uint32_t getFreeHeap();
+
+// Allocations since boot, diff it across a frame to get per-frame counts
+uint32_t getAllocationCount();
+
+// Marks the end of init and snapshots the free heap. With HEAP_CHECK
+// set any allocation after this panics.
+void sealHeap();
+bool isHeapSealed();
+uint32_t getSealedFreeHeap();
@@ -0,0 +1,104 @@
+#include "history.hpp"
+
+void HistoryBucket::clear() {
+  min = INT32_MAX;
+  max = INT32_MIN;
+  sum = 0;
+  count = 0;
+}
+
+void HistoryBucket::add(q16 value) {
+  if(value < min) min = value;
+  if(value > max) max = value;
+  sum += value;
+  count++;
+}
+
+void HistoryBucket::merge(const HistoryBucket& other) {
+  if(other.count == 0) return;
+  if(other.min < min) min = other.min;
+  if(other.max > max) max = other.max;
+  sum += other.sum;
+  count += other.count;
+}
+
+q16 HistoryBucket::average() const {
+  return count ? (q16)(sum / (int64_t)count) : 0;
+}
+
+void HistoryTier::clear() {
+  for(auto& b : buckets) {
+    b.clear();
+  }
+  next = 0;
+  open.clear();
+  openIndex = 0;
+  started = false;
+  closed.clear();
+}
+
+const HistoryBucket& HistoryTier::bucket(int i) const {
+  return buckets[(next + i) % HISTORY_BUCKETS];
+}
+
+// Closes the open bucket, handing it up to the parent tier, until `index`
+// is the open one
+static void advanceTier(HistoryTier* tiers, int tier, uint32_t index) {
+  HistoryTier& t = tiers[tier];
+
+  if(!t.started) {
+    t.openIndex = index;
+    t.started = true;
+    return;
+  }
+
+  while(t.openIndex < index) {
+    if(tier + 1 < HISTORY_TIERS && t.open.count > 0) {
+      uint32_t seconds = t.openIndex * HISTORY_BUCKET_SECONDS[tier];
+      advanceTier(tiers, tier + 1, seconds / HISTORY_BUCKET_SECONDS[tier + 1]);
+      tiers[tier + 1].open.merge(t.open);
+    }
+
+    t.buckets[t.next] = t.open;
+    t.next = (t.next + 1) % HISTORY_BUCKETS;
+    t.open.clear();
+    t.openIndex++;
+
+    // After a long gap only the last window's worth of empty buckets matter
+    if(index - t.openIndex > HISTORY_BUCKETS) {
+      t.openIndex = index - HISTORY_BUCKETS;
+    }
+
+    // Once per bucket rather than per sample, min and max can't be
+    // unwound when the oldest bucket drops out
+    t.closed.clear();
+    for(auto& b : t.buckets) {
+      t.closed.merge(b);
+    }
+  }
+}
+
+void HistorySeries::clear() {
+  for(auto& t : tiers) {
+    t.clear();
+  }
+}
+
+void HistorySeries::add(q16 value, uint32_t seconds) {
+  advanceTier(tiers, HISTORY_HOUR, seconds / HISTORY_BUCKET_SECONDS[HISTORY_HOUR]);
+  tiers[HISTORY_HOUR].open.add(value);
+}
+
+HistoryBucket HistorySeries::newest(HISTORY_TIER tier) const {
+  HistoryBucket all = tiers[tier].open;
+  for(int t = 0; t < tier; t++) {
+    all.merge(tiers[t].open);
+  }
+  return all;
+}
+
+HistoryBucket HistorySeries::stats(HISTORY_TIER tier) const {
+  HistoryBucket all = tiers[tier].closed;
+  all.merge(newest(tier));
+  return all;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "fixed.hpp"
+
+// Fixed-size time series for the environment readings. Samples land in
+// short buckets for the last hour, and each finished hour bucket is merged
+// into a longer one for the last day, so drawing either never touches raw
+// samples.
+
+static const int HISTORY_BUCKETS = 48;
+
+enum HISTORY_TIER {
+  HISTORY_HOUR = 0,
+  HISTORY_DAY = 1,
+  HISTORY_TIERS
+};
+
+// 48 x 75s is an hour, 48 x 30min is a day
+static const uint32_t HISTORY_BUCKET_SECONDS[HISTORY_TIERS] = {75, 30 * 60};
+
+struct HistoryBucket {
+  q16 min = INT32_MAX;
+  q16 max = INT32_MIN;
+  int64_t sum = 0;
+  uint32_t count = 0;
+
+  void clear();
+  void add(q16 value);
+  void merge(const HistoryBucket& other);
+  q16 average() const;
+};
+
+struct HistoryTier {
+  // Ring of finished buckets, oldest at `next`
+  HistoryBucket buckets[HISTORY_BUCKETS];
+  int next = 0;
+
+  // Bucket currently being filled and which period it covers
+  HistoryBucket open;
+  uint32_t openIndex = 0;
+  bool started = false;
+
+  // Totals over the finished buckets, refreshed as each one closes
+  HistoryBucket closed;
+
+  void clear();
+
+  // Finished bucket `i`, 0 being the oldest still kept
+  const HistoryBucket& bucket(int i) const;
+};
+
+struct HistorySeries {
+  HistoryTier tiers[HISTORY_TIERS];
+
+  void clear();
+
+  // Seconds is any monotonic clock, gaps leave empty buckets
+  void add(q16 value, uint32_t seconds);
+
+  // A tier's open bucket plus samples the shorter tiers haven't handed
+  // up yet, the newest point on its graph
+  HistoryBucket newest(HISTORY_TIER tier) const;
+
+  // Everything in a tier's window
+  HistoryBucket stats(HISTORY_TIER tier) const;
+};
@@ -0,0 +1,11 @@
+// Runs the render benchmarks on the host, e.g. `jimneyio_bench 2000 > bench.jsonl`
+
+#include <stdlib.h>
+
+#include "bench.hpp"
+
+int main(int argc, char** argv) {
+  int samples = argc > 1 ? atoi(argv[1]) : 1000;
+  runRenderBenchmarks("host", samples);
+  return 0;
+}
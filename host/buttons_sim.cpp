@@ -0,0 +1,189 @@
+// Runs buttons.cpp against simulated pins and alarms and checks the events
+// that come out, e.g. `jimneyio_buttons > buttons.jsonl`
+//
+// Each scenario drives the pins through a press pattern, with contact
+// bounce where it matters, and compares every queued event's type, button,
+// time and chord against what should have come out. Prints one JSON object
+// per scenario and exits non-zero if any differ.
+
+#include <stdio.h>
+#include <vector>
+
+#include "types.hpp"
+#include "buttons.hpp"
+#include "host_alarms.hpp"
+#include "host_gpio.hpp"
+
+// Well clear of zero so nothing starts inside a debounce window
+static const uint64_t START_US = 1000000;
+
+// Between scenarios, long enough for every alarm to have run
+static const uint64_t SETTLE_US = 2000000;
+
+static const uint BUTTON_PINS[] = {A, B, X, Y};
+
+struct Expected {
+  BUTTON_EVENT type;
+  BUTTON button;
+  uint32_t atMs;
+  uint8_t chord;
+};
+
+static uint64_t scenarioStartUs;
+
+// Buttons pull the pin low
+static void setButton(BUTTON button, bool down) {
+  setHostPin(BUTTON_PINS[button], !down);
+}
+
+static void wait(uint32_t us) {
+  runHostAlarms(us);
+}
+
+static const char* eventName(BUTTON_EVENT type) {
+  switch(type) {
+    case BUTTON_PRESS: return "press";
+    case BUTTON_RELEASE: return "release";
+    case BUTTON_LONG_PRESS: return "long_press";
+    case BUTTON_CHORD: return "chord";
+  }
+  return "?";
+}
+
+static bool check(const char* name, const std::vector<Expected>& expected) {
+  std::vector<ButtonEvent> events;
+  ButtonEvent event;
+  while(readButtonEvent(event)) {
+    events.push_back(event);
+  }
+
+  bool ok = events.size() == expected.size();
+  for(size_t i = 0; ok && i < events.size(); i++) {
+    uint32_t atMs = (events[i].timeUs - (uint32_t)scenarioStartUs) / 1000;
+    ok = events[i].type == expected[i].type && events[i].button == expected[i].button &&
+      atMs == expected[i].atMs && events[i].chord == expected[i].chord;
+  }
+
+  if(!ok) {
+    for(auto& e : events) {
+      fprintf(stderr, "%s: got %s %c at %ums chord %x\n", name, eventName(e.type), "ABXY"[e.button],
+        (e.timeUs - (uint32_t)scenarioStartUs) / 1000, e.chord);
+    }
+    for(auto& e : expected) {
+      fprintf(stderr, "%s: wanted %s %c at %ums chord %x\n", name, eventName(e.type), "ABXY"[e.button], e.atMs, e.chord);
+    }
+  }
+
+  printf("{\"scenario\":\"%s\",\"events\":%zu,\"ok\":%s}\n", name, events.size(), ok ? "true" : "false");
+  return ok;
+}
+
+static void startScenario() {
+  wait(SETTLE_US);
+  ButtonEvent event;
+  while(readButtonEvent(event)) {
+  }
+  scenarioStartUs = time_us_64();
+}
+
+int main() {
+  startHostClock(START_US);
+
+  // Held through boot, so its release is the first thing seen
+  setButton(BUTTON_Y, true);
+  initButtons();
+  int failures = 0;
+
+  startScenario();
+  setButton(BUTTON_Y, false);
+  wait(50000);
+  failures += !check("held_through_boot", {
+    {BUTTON_RELEASE, BUTTON_Y, 0, 0},
+  });
+
+  // Contacts chattering on the way down and up only count once each way
+  startScenario();
+  setButton(BUTTON_A, true);
+  wait(1000);
+  setButton(BUTTON_A, false);
+  wait(500);
+  setButton(BUTTON_A, true);
+  wait(100000);
+  setButton(BUTTON_A, false);
+  wait(2000);
+  setButton(BUTTON_A, true);
+  wait(300);
+  setButton(BUTTON_A, false);
+  wait(50000);
+  failures += !check("bouncy_press", {
+    {BUTTON_PRESS, BUTTON_A, 0, 0},
+    {BUTTON_RELEASE, BUTTON_A, 101, 0},
+  });
+
+  // Shorter than the debounce, the settle alarm catches the release
+  startScenario();
+  setButton(BUTTON_B, true);
+  wait(5000);
+  setButton(BUTTON_B, false);
+  wait(50000);
+  failures += !check("short_press", {
+    {BUTTON_PRESS, BUTTON_B, 0, 0},
+    {BUTTON_RELEASE, BUTTON_B, 20, 0},
+  });
+
+  startScenario();
+  setButton(BUTTON_X, true);
+  wait(1000000);
+  setButton(BUTTON_X, false);
+  wait(50000);
+  failures += !check("long_press", {
+    {BUTTON_PRESS, BUTTON_X, 0, 0},
+    {BUTTON_LONG_PRESS, BUTTON_X, 800, 0},
+    {BUTTON_RELEASE, BUTTON_X, 1000, 0},
+  });
+
+  // Released before the long press is due, its alarm must not fire later
+  startScenario();
+  setButton(BUTTON_X, true);
+  wait(500000);
+  setButton(BUTTON_X, false);
+  wait(1000000);
+  failures += !check("released_before_long_press", {
+    {BUTTON_PRESS, BUTTON_X, 0, 0},
+    {BUTTON_RELEASE, BUTTON_X, 500, 0},
+  });
+
+  startScenario();
+  setButton(BUTTON_A, true);
+  wait(30000);
+  setButton(BUTTON_B, true);
+  wait(100000);
+  setButton(BUTTON_A, false);
+  setButton(BUTTON_B, false);
+  wait(50000);
+  failures += !check("chord", {
+    {BUTTON_PRESS, BUTTON_A, 0, 0},
+    {BUTTON_PRESS, BUTTON_B, 30, 0},
+    {BUTTON_CHORD, BUTTON_B, 30, (1 << BUTTON_A) | (1 << BUTTON_B)},
+    {BUTTON_RELEASE, BUTTON_A, 130, 0},
+    {BUTTON_RELEASE, BUTTON_B, 130, 0},
+  });
+
+  // Too far apart to be meant together
+  startScenario();
+  setButton(BUTTON_A, true);
+  wait(200000);
+  setButton(BUTTON_B, true);
+  wait(100000);
+  setButton(BUTTON_A, false);
+  setButton(BUTTON_B, false);
+  wait(50000);
+  failures += !check("no_chord", {
+    {BUTTON_PRESS, BUTTON_A, 0, 0},
+    {BUTTON_PRESS, BUTTON_B, 200, 0},
+    {BUTTON_RELEASE, BUTTON_A, 300, 0},
+    {BUTTON_RELEASE, BUTTON_B, 300, 0},
+  });
+
+  return failures == 0 ? 0 : 1;
+}
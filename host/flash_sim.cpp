@@ -0,0 +1,180 @@
+// Runs state.cpp against a simulated flash chip and prints one JSON object
+// per phase, e.g. `jimneyio_flash 1000000 100000 50 > flash.jsonl`
+//
+// The wear phase plays button presses through the same save scheduler as
+// the firmware, rebooting now and then, and turns the erase counts into a
+// flash lifetime at the given presses per day. The power loss phase cuts
+// power at a random byte of the flash work, reboots and checks the state
+// that comes back is either the last one saved or the one being written.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <random>
+#include <algorithm>
+
+#include "types.hpp"
+#include "ui.hpp"
+#include "state.hpp"
+#include "nor_flash.hpp"
+
+static const uint32_t REBOOT_EVERY = 1000;
+
+static const uint32_t SETTINGS_FIRST_SECTOR = SETTINGS_BEGIN_WRITE / KV_SECTOR_SIZE;
+
+static bool sameState(const State& a, const State& b) {
+  return memcmp(a.state, b.state, sizeof(a.state)) == 0;
+}
+
+static State stateOf(const UiState& ui) {
+  return State(ui.mode, ui.units);
+}
+
+// Mostly a mode change now and then, sometimes a quick run of presses on A
+// flicking the units back and forth
+static uint32_t nextPressGap(std::mt19937& random) {
+  if(random() % 10 < 3) return 150 + random() % 450;
+  return 5000 + random() % 600000;
+}
+
+static BUTTON nextButton(std::mt19937& random) {
+  return random() % 3 ? BUTTON_A : BUTTON_B;
+}
+
+// What a reboot costs in flash reads, and whether the store survived it
+struct Boot {
+  State state = State(ENVIRONMENT, CELSIUS);
+  uint64_t reads = 0;
+  uint32_t erases = 0;
+};
+
+static Boot reboot() {
+  Boot boot;
+  uint64_t readsBefore = hostFlash.reads;
+  uint32_t erasesBefore = 0;
+  for(uint32_t i = 0; i < SETTINGS_SECTORS; i++) {
+    erasesBefore += hostFlash.sectorErases[SETTINGS_FIRST_SECTOR + i];
+  }
+
+  boot.state = loadState();
+
+  boot.reads = hostFlash.reads - readsBefore;
+  for(uint32_t i = 0; i < SETTINGS_SECTORS; i++) {
+    boot.erases += hostFlash.sectorErases[SETTINGS_FIRST_SECTOR + i];
+  }
+  boot.erases -= erasesBefore;
+  return boot;
+}
+
+static int runWear(uint32_t presses, uint32_t pressesPerDay) {
+  std::mt19937 random(1);
+  UiState ui;
+  ui.mode = ENVIRONMENT;
+  Boot boot = reboot();
+
+  uint32_t nowMs = 0;
+  uint32_t commits = 0, mismatches = 0;
+  uint64_t maxCommitUs = 0, maxBootReads = 0, totalBootReads = 0, boots = 0;
+  State saved = boot.state;
+
+  for(uint32_t i = 0; i < presses; i++) {
+    nowMs += nextPressGap(random);
+
+    // Anything that settled since the last press has gone to flash by now
+    if(isStateCommitDue(nowMs)) {
+      uint64_t busyBefore = hostFlash.busyUs;
+      commitState();
+      maxCommitUs = std::max(maxCommitUs, hostFlash.busyUs - busyBefore);
+      saved = stateOf(ui);
+      commits++;
+    }
+
+    applyButtonPress(ui, nextButton(random));
+    saveStateLater(stateOf(ui), nowMs);
+
+    if(i % REBOOT_EVERY == REBOOT_EVERY - 1) {
+      // A pending change is lost with the power, same as on the Pico
+      boot = reboot();
+      if(!sameState(boot.state, saved)) mismatches++;
+      ui.mode = boot.state.getMode();
+      ui.units = boot.state.getUnits();
+      saveStateLater(stateOf(ui), nowMs);
+
+      maxBootReads = std::max(maxBootReads, boot.reads);
+      totalBootReads += boot.reads;
+      boots++;
+    }
+  }
+
+  uint32_t minErases = UINT32_MAX, maxErases = 0;
+  for(uint32_t i = 0; i < SETTINGS_SECTORS; i++) {
+    uint32_t erases = hostFlash.sectorErases[SETTINGS_FIRST_SECTOR + i];
+    minErases = std::min(minErases, erases);
+    maxErases = std::max(maxErases, erases);
+  }
+
+  // Presses until the most worn sector reaches its rated erase count
+  double pressesToWearOut = maxErases ? (double)presses * NOR_ERASE_ENDURANCE / maxErases : 0;
+  double meanBootReads = boots ? (double)totalBootReads / boots : 0;
+
+  printf("{\"phase\":\"wear\",\"presses\":%u,\"commits\":%u,\"page_programs\":%llu,"
+    "\"sector_erases_min\":%u,\"sector_erases_max\":%u,\"overwrites\":%llu,"
+    "\"flash_busy_ms\":%.1f,\"commit_max_us\":%llu,"
+    "\"boot_reads_mean\":%.1f,\"boot_reads_max\":%llu,"
+    "\"boot_mismatches\":%u,\"presses_per_day\":%u,\"lifetime_years\":%.0f}\n",
+    presses, commits, (unsigned long long)hostFlash.pagePrograms,
+    minErases, maxErases, (unsigned long long)hostFlash.overwrites,
+    hostFlash.busyUs / 1000.0, (unsigned long long)maxCommitUs,
+    meanBootReads, (unsigned long long)maxBootReads,
+    mismatches, pressesPerDay, pressesToWearOut / pressesPerDay / 365);
+
+  return mismatches ? 1 : 0;
+}
+
+static int runPowerLoss(uint32_t trials) {
+  std::mt19937 random(2);
+  uint32_t lost = 0, wrong = 0, cuts = 0;
+  State saved = reboot().state;
+
+  for(uint32_t trial = 0; trial < trials; trial++) {
+    // Enough bytes to land anywhere in a few commits, compactions included
+    hostFlash.cutPowerAfter(random() % (4 * KV_SECTOR_SIZE));
+
+    State writing = saved;
+    while(!hostFlash.isPoweredOff()) {
+      UiState ui;
+      ui.mode = random() % 2 ? ENVIRONMENT : INCLINOMETER;
+      ui.units = random() % 2 ? CELSIUS : FAHRENHEIT;
+      writing = stateOf(ui);
+
+      saveStateLater(writing, 0);
+      commitState();
+      if(!hostFlash.isPoweredOff()) saved = writing;
+    }
+    cuts++;
+
+    hostFlash.powerOn();
+    Boot boot = reboot();
+
+    // Erasing every sector means mount gave up and the store was formatted
+    if(boot.erases >= SETTINGS_SECTORS) lost++;
+    if(!sameState(boot.state, saved) && !sameState(boot.state, writing)) wrong++;
+    saved = boot.state;
+  }
+
+  printf("{\"phase\":\"power_loss\",\"trials\":%u,\"cuts\":%u,\"stores_lost\":%u,\"wrong_states\":%u}\n",
+    trials, cuts, lost, wrong);
+
+  return lost || wrong ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+  uint32_t presses = argc > 1 ? atoi(argv[1]) : 1000000;
+  uint32_t trials = argc > 2 ? atoi(argv[2]) : 100000;
+  uint32_t pressesPerDay = argc > 3 ? atoi(argv[3]) : 50;
+  if(pressesPerDay == 0) pressesPerDay = 1;
+
+  int result = runWear(presses, pressesPerDay);
+  result |= runPowerLoss(trials);
+  return result;
+}
@@ -0,0 +1,140 @@
+// Renders every screen without hardware and writes each framebuffer to a
+// PPM file, e.g. `jimneyio_headless out/`
+//
+// Also draws each screen as two bands through separate clipped views of
+// one buffer, the way JIMNEYIO_SPLIT_RENDER splits a frame between the
+// cores, and fails if any split comes out different from the whole frame.
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+#include "types.hpp"
+#include "pens.hpp"
+#include "splash.hpp"
+#include "jimney.hpp"
+#include "environment.hpp"
+#include "inclinometer.hpp"
+#include "ui.hpp"
+#include "host_sensors.hpp"
+#include "ppm.hpp"
+
+// The stand-in IMU starts level, step it into a tilt
+static const int INCLINOMETER_WARMUP_FRAMES = 8;
+
+// A day of one-second samples swinging around the warm cab default, so
+// both history graphs have something to show
+static void recordSyntheticDay() {
+  const uint32_t DAY = 24 * 60 * 60;
+  for(uint32_t t = 0; t < DAY; t++) {
+    float phase = 2.0f * (float)M_PI * t / DAY;
+    EnvironmentSample sample = {30.0f + 6.0f * sinf(phase) + 0.5f * sinf(phase * 40), 101325.0f, 45.0f, 50000.0f, true};
+    recordEnvironmentSample(sample, t);
+  }
+}
+
+static std::string outputDir = ".";
+static int failures = 0;
+
+static void save(const PicoGraphics_PenRGB332& graphics, const char* name) {
+  std::string path = outputDir + "/" + name + ".ppm";
+  if(writePPM(path.c_str(), graphics)) {
+    printf("%s\n", path.c_str());
+  } else {
+    fprintf(stderr, "failed to write %s\n", path.c_str());
+    failures++;
+  }
+}
+
+// Every split row from one band of a row up to the other, a prime step so
+// the rows land on varied offsets into the sprites and text
+static const int BAND_SPLIT_STEP = 7;
+
+static void checkBands(PicoGraphics_PenRGB332& graphics, Pens& pens, const UiState& ui, const char* name) {
+  static uint8_t bandBuffer[WIDTH * HEIGHT];
+  PicoGraphics_PenRGB332 top(WIDTH, HEIGHT, bandBuffer);
+  PicoGraphics_PenRGB332 bottom(WIDTH, HEIGHT, bandBuffer);
+  initGraphics(top);
+  initGraphics(bottom);
+
+  updateScreen(ui);
+  drawScreen(graphics, pens, ui);
+
+  int splits = 0;
+  int mismatches = 0;
+  for(int split = 1; split < HEIGHT; split += BAND_SPLIT_STEP) {
+    // Anything either band leaves alone shows up as a difference
+    memset(bandBuffer, 0x5A, sizeof(bandBuffer));
+    top.set_clip(Rect(0, 0, WIDTH, split));
+    bottom.set_clip(Rect(0, split, WIDTH, HEIGHT - split));
+    drawScreen(bottom, pens, ui);
+    drawScreen(top, pens, ui);
+
+    splits++;
+    if(memcmp(bandBuffer, graphics.frame_buffer, sizeof(bandBuffer)) != 0) {
+      fprintf(stderr, "%s: bands split at row %d differ from the whole frame\n", name, split);
+      mismatches++;
+    }
+  }
+
+  printf("bands %s: %d/%d splits match\n", name, splits - mismatches, splits);
+  failures += mismatches;
+}
+
+int main(int argc, char** argv) {
+  if(argc > 1) {
+    outputDir = argv[1];
+  }
+
+  PicoGraphics_PenRGB332 graphics(WIDTH, HEIGHT, nullptr);
+  Pens pens = initGraphics(graphics);
+
+  initEnvironment();
+  initInclinometer();
+
+  renderSplashFrame(graphics, pens);
+  save(graphics, "splash");
+
+  updateEnvironment(0);
+  renderEnvironmentFrame(graphics, pens, CELSIUS);
+  save(graphics, "environment_celsius");
+
+  renderEnvironmentFrame(graphics, pens, FAHRENHEIT);
+  save(graphics, "environment_fahrenheit");
+
+  setHostEnvironmentSample(EnvironmentSample{30.0f, 101325.0f, 45.0f, 50000.0f, false});
+  updateEnvironment(0);
+  renderEnvironmentFrame(graphics, pens, CELSIUS);
+  save(graphics, "environment_heating");
+
+  recordSyntheticDay();
+  renderEnvironmentFrame(graphics, pens, CELSIUS);
+  save(graphics, "environment_history");
+
+  for(int i = 0; i < INCLINOMETER_WARMUP_FRAMES; i++) {
+    renderInclinometerFrame(graphics, pens);
+  }
+  save(graphics, "inclinometer");
+
+  graphics.set_pen(pens.BLACK);
+  graphics.clear();
+  drawJimny(graphics, 56, 56, DARK);
+  save(graphics, "jimny_dark");
+
+  graphics.set_pen(pens.BLACK);
+  graphics.clear();
+  drawJimny(graphics, 56, 56, LIGHT);
+  save(graphics, "jimny_light");
+
+  UiState ui;
+  checkBands(graphics, pens, ui, "splash");
+  ui.mode = ENVIRONMENT;
+  checkBands(graphics, pens, ui, "environment");
+  ui.units = FAHRENHEIT;
+  checkBands(graphics, pens, ui, "environment_fahrenheit");
+  ui.mode = INCLINOMETER;
+  checkBands(graphics, pens, ui, "inclinometer");
+
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,58 @@
+#include "host_alarms.hpp"
+
+#include <map>
+
+struct HostAlarm {
+  uint64_t dueUs;
+  alarm_callback_t callback;
+  void* userData;
+};
+
+static std::map<alarm_id_t, HostAlarm> alarms;
+static alarm_id_t nextAlarmId = 1;
+
+void startHostClock(uint64_t nowUs) {
+  hostClockSimulated = true;
+  hostSimulatedUs = nowUs;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void* userData, bool fireIfPast) {
+  alarm_id_t id = nextAlarmId++;
+  alarms[id] = {time_us_64() + us, callback, userData};
+  return id;
+}
+
+bool cancel_alarm(alarm_id_t id) {
+  return alarms.erase(id) > 0;
+}
+
+void runHostAlarms(uint64_t us) {
+  uint64_t endUs = hostSimulatedUs + us;
+
+  while(true) {
+    // Earliest first, the first added on a tie like the SDK's pool
+    auto due = alarms.end();
+    for(auto it = alarms.begin(); it != alarms.end(); ++it) {
+      if(it->second.dueUs <= endUs && (due == alarms.end() || it->second.dueUs < due->second.dueUs)) {
+        due = it;
+      }
+    }
+    if(due == alarms.end()) break;
+
+    alarm_id_t id = due->first;
+    HostAlarm alarm = due->second;
+    alarms.erase(due);
+    hostSimulatedUs = alarm.dueUs;
+
+    // Same as the SDK, positive reschedules from when it was due and
+    // negative from now
+    int64_t next = alarm.callback(id, alarm.userData);
+    if(next > 0) {
+      alarms[id] = {alarm.dueUs + next, alarm.callback, alarm.userData};
+    } else if(next < 0) {
+      alarms[id] = {hostSimulatedUs - next, alarm.callback, alarm.userData};
+    }
+  }
+
+  hostSimulatedUs = endUs;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "pico/time.h"
+
+// Stand-in for the default alarm pool on a simulated clock. Alarms added
+// with add_alarm_in_us() only fire inside runHostAlarms(), in time order,
+// with time_us_64() reading the moment each was due.
+
+// Switches time_us_64() over to the simulated clock, starting at `nowUs`
+void startHostClock(uint64_t nowUs);
+
+// Moves the clock forward by `us`, firing every alarm due on the way
+void runHostAlarms(uint64_t us);
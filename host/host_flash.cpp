@@ -0,0 +1,35 @@
+// Stand-in for flash_backend.cpp, puts PicoFlashBackend on a simulated
+// chip so state.cpp runs unchanged on the host
+
+#include "flash_backend.hpp"
+#include "nor_flash.hpp"
+#include "state.hpp"
+
+#include <string.h>
+
+// Anything other than PICO_OK, the SDK reports a timed out lockout this way
+static const int HOST_FLASH_ERROR = -1;
+
+NorFlash hostFlash(EEPROM_SIZE);
+
+const uint8_t* PicoFlashBackend::read(uint32_t offset) {
+  return hostFlash.read(flashOffset + offset);
+}
+
+bool PicoFlashBackend::erase(uint32_t offset) {
+  bool ok = hostFlash.erase(flashOffset + offset);
+  lastError = ok ? 0 : HOST_FLASH_ERROR;
+  return ok;
+}
+
+bool PicoFlashBackend::program(uint32_t offset, const uint8_t* data, size_t length) {
+  // Same whole page writes as the Pico, padded with 0xFF
+  uint8_t page[KV_PAGE_SIZE];
+  uint32_t pageStart = offset - offset % KV_PAGE_SIZE;
+  memset(page, 0xFF, sizeof(page));
+  memcpy(page + (offset - pageStart), data, length);
+
+  bool ok = hostFlash.program(flashOffset + pageStart, page, sizeof(page));
+  lastError = ok ? 0 : HOST_FLASH_ERROR;
+  return ok;
+}
@@ -0,0 +1,45 @@
+#include "host_gpio.hpp"
+
+static const int PIN_COUNT = 30;
+
+// What's wired to the pin, or the pull-up while nothing drives it
+static bool driven[PIN_COUNT];
+static bool levels[PIN_COUNT];
+static bool pulledUp[PIN_COUNT];
+static uint32_t irqEvents[PIN_COUNT];
+
+// Like the SDK, one callback per core for every pin
+static gpio_irq_callback_t irqCallback = nullptr;
+
+void gpio_init(uint gpio) {
+  pulledUp[gpio] = false;
+  irqEvents[gpio] = 0;
+}
+
+void gpio_set_dir(uint gpio, bool out) {
+}
+
+void gpio_pull_up(uint gpio) {
+  pulledUp[gpio] = true;
+}
+
+bool gpio_get(uint gpio) {
+  return driven[gpio] ? levels[gpio] : pulledUp[gpio];
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t eventMask, bool enabled, gpio_irq_callback_t callback) {
+  irqEvents[gpio] = enabled ? eventMask : 0;
+  irqCallback = callback;
+}
+
+void setHostPin(uint gpio, bool high) {
+  bool was = gpio_get(gpio);
+  driven[gpio] = true;
+  levels[gpio] = high;
+  if(was == high) return;
+
+  uint32_t event = high ? GPIO_IRQ_EDGE_RISE : GPIO_IRQ_EDGE_FALL;
+  if((irqEvents[gpio] & event) && irqCallback) {
+    irqCallback(gpio, event);
+  }
+}
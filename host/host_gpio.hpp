@@ -0,0 +1,7 @@
+#pragma once
+
+#include "hardware/gpio.h"
+
+// Sets what gpio_get() reads for a pin and raises the edge interrupt if
+// the level changed and the pin has one enabled
+void setHostPin(uint gpio, bool high);
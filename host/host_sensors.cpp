@@ -0,0 +1,64 @@
+#include "host_sensors.hpp"
+
+// Stand-in for the BME68X, holds whatever the harness last set
+static EnvironmentSample hostSample = {30.0f, 101325.0f, 45.0f, 50000.0f, true};
+static bool hostSampleReady = false;
+
+void setHostEnvironmentSample(const EnvironmentSample& sample) {
+  hostSample = sample;
+  hostSampleReady = true;
+}
+
+void initEnvironmentSensor() {
+  hostSampleReady = true;
+}
+
+// Like the sensor, each sample is only handed out once
+bool readEnvironmentSample(EnvironmentSample& sample) {
+  if(!hostSampleReady) return false;
+
+  sample = hostSample;
+  hostSampleReady = false;
+  return true;
+}
+
+// Stand-in for the IMU, sweeps pitch and roll back and forth a step per call
+static int testPitch = 0;
+static int testRoll = 0;
+static const int MAX_TEST_PITCH = 16;
+static const int MAX_TEST_ROLL = 5;
+static bool isPitchReversing = false;
+static bool isRollReversing = false;
+
+void initMotionSensor() {
+}
+
+bool readAttitude(Attitude& attitude) {
+  if(testPitch < MAX_TEST_PITCH && !isPitchReversing) {
+    testPitch += 2;
+    if(testPitch == MAX_TEST_PITCH) isPitchReversing = true;
+  }
+  else if(testPitch > -1*MAX_TEST_PITCH && isPitchReversing) {
+    testPitch -= 2;
+    if(testPitch == -1*MAX_TEST_PITCH) isPitchReversing = false;
+  }
+
+  if(testRoll < MAX_TEST_ROLL && !isRollReversing) {
+    testRoll += 1;
+    if(testRoll == MAX_TEST_ROLL) isRollReversing = true;
+  }
+  else if(testRoll > -1*MAX_TEST_ROLL && isRollReversing) {
+    testRoll -= 1;
+    if(testRoll == -1*MAX_TEST_ROLL) isRollReversing = false;
+  }
+
+  attitude.pitch = degreesToAngle(toQ16(testPitch));
+  attitude.roll = degreesToAngle(toQ16(testRoll));
+  return true;
+}
+
+void setMotionRate(MOTION_RATE rate) {
+}
+
+void applySensorBusClock() {
+}
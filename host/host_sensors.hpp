@@ -0,0 +1,8 @@
+#pragma once
+
+#include "sensors.hpp"
+
+// Publishes the next sample readEnvironmentSample() returns on the host,
+// initEnvironmentSensor() publishes a warm cab (30°C raw, 21°C after the
+// self-heating offset)
+void setHostEnvironmentSample(const EnvironmentSample& sample);
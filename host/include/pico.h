@@ -0,0 +1,15 @@
+#pragma once
+
+// Just enough of the Pico SDK for the renderers and pimoroni's
+// pico_graphics to build on a Linux host
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#define XIP_BASE 0x10000000
+
+#define __not_in_flash_func(func_name) func_name
+#define __time_critical_func(func_name) func_name
+#define __not_in_flash(group)
+#define __in_flash(group)
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <stdio.h>
+#include "pico.h"
+#include "pico/time.h"
+
+static inline void tight_loop_contents() {}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+#include "pico.h"
+
+typedef uint64_t absolute_time_t;
+
+// Harnesses that need time to stand still between steps set this and move
+// hostSimulatedUs themselves, see host_alarms.hpp. Everything else runs on
+// the real clock.
+inline bool hostClockSimulated = false;
+inline uint64_t hostSimulatedUs = 0;
+
+// Plain inline, not static, so every file shares the one boot time below
+inline uint64_t time_us_64() {
+  if(hostClockSimulated) return hostSimulatedUs;
+
+  static const auto boot = std::chrono::steady_clock::now();
+  return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - boot).count();
+}
+
+inline uint32_t time_us_32() {
+  return (uint32_t)time_us_64();
+}
+
+inline absolute_time_t get_absolute_time() {
+  return time_us_64();
+}
+
+inline uint64_t to_us_since_boot(absolute_time_t t) {
+  return t;
+}
+
+inline uint32_t to_ms_since_boot(absolute_time_t t) {
+  return (uint32_t)(t / 1000);
+}
+
+inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to) {
+  return (int64_t)(to - from);
+}
+
+inline void sleep_us(uint64_t us) {
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+inline void sleep_ms(uint32_t ms) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+// Alarms only fire on the host when a harness runs them, host_alarms.cpp
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void* user_data);
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void* user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
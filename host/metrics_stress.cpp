@@ -0,0 +1,67 @@
+// Hammers the metrics seqlock from two threads and counts torn snapshots,
+// e.g. `jimneyio_metrics 5000000`
+//
+// One thread records 1, 2, 3... into a histogram and a counter, standing in
+// for the core that owns them. The main thread reads snapshots the whole
+// time, like the other core drawing the stats overlay. A whole update
+// always has value == count == max, min 1 and as many samples in the
+// buckets as the count, so any snapshot that doesn't was read mid-update.
+// Prints one JSON object and exits non-zero if any were torn.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+
+#include "metrics.hpp"
+
+static Histogram stressHistogram("stress", "us");
+static Counter stressCounter("stress_count");
+
+static bool isWhole(const MetricSnapshot& s, bool histogram) {
+  if(s.count == 0) return true;
+  if((uint32_t)s.value != s.count) return false;
+  if(!histogram) return true;
+
+  uint32_t samples = 0;
+  for(size_t i = 0; i < METRIC_BUCKETS; i++) {
+    samples += s.buckets[i];
+  }
+  return samples == s.count && s.max == s.value && s.min == 1;
+}
+
+int main(int argc, char** argv) {
+  int32_t writes = argc > 1 ? atoi(argv[1]) : 5000000;
+  if(writes < 1) writes = 1;
+
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    for(int32_t i = 1; i <= writes; i++) {
+      stressHistogram.record(i);
+      stressCounter.add();
+    }
+    done.store(true);
+  });
+
+  uint64_t reads = 0;
+  uint64_t torn = 0;
+  while(!done.load()) {
+    MetricSnapshot snapshot;
+    stressHistogram.read(snapshot);
+    torn += !isWhole(snapshot, true);
+    stressCounter.read(snapshot);
+    torn += !isWhole(snapshot, false);
+    reads += 2;
+  }
+  writer.join();
+
+  // And nothing lost once the writer has finished
+  MetricSnapshot histogram, counter;
+  stressHistogram.read(histogram);
+  stressCounter.read(counter);
+  bool complete = histogram.count == (uint32_t)writes && counter.value == writes && isWhole(histogram, true);
+
+  printf("{\"writes\":%d,\"reads\":%llu,\"torn\":%llu,\"complete\":%s}\n",
+    writes, (unsigned long long)reads, (unsigned long long)torn, complete ? "true" : "false");
+  return torn == 0 && complete ? 0 : 1;
+}
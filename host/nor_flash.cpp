@@ -0,0 +1,72 @@
+#include "nor_flash.hpp"
+
+#include <string.h>
+
+NorFlash::NorFlash(uint32_t size, uint32_t seed)
+  : memory(size, 0xFF), sectorErases(size / KV_SECTOR_SIZE, 0), random(seed) {}
+
+const uint8_t* NorFlash::read(uint32_t offset) {
+  reads++;
+  return memory.data() + offset;
+}
+
+size_t NorFlash::bytesBeforeCut(size_t length) {
+  if(powerBudget < 0) return length;
+  if((int64_t)length < powerBudget) {
+    powerBudget -= length;
+    return length;
+  }
+
+  size_t done = powerBudget;
+  powerBudget = -1;
+  poweredOff = true;
+  return done;
+}
+
+bool NorFlash::erase(uint32_t offset) {
+  if(poweredOff || offset % KV_SECTOR_SIZE != 0 || offset >= memory.size()) return false;
+
+  uint8_t* sector = memory.data() + offset;
+  size_t done = bytesBeforeCut(KV_SECTOR_SIZE);
+  memset(sector, 0xFF, done);
+
+  sectorErases[offset / KV_SECTOR_SIZE]++;
+  busyUs += NOR_SECTOR_ERASE_US;
+
+  // Erase only ever sets bits, a cut one leaves some of them set
+  for(size_t i = done; i < KV_SECTOR_SIZE; i++) {
+    sector[i] |= random();
+  }
+  return !poweredOff;
+}
+
+bool NorFlash::program(uint32_t offset, const uint8_t* data, size_t length) {
+  if(poweredOff || length == 0 || offset + length > memory.size()) return false;
+  if(offset / KV_PAGE_SIZE != (offset + length - 1) / KV_PAGE_SIZE) return false;
+
+  uint8_t* target = memory.data() + offset;
+  for(size_t i = 0; i < length; i++) {
+    if(data[i] != 0xFF && (target[i] & data[i]) != data[i]) overwrites++;
+  }
+
+  size_t done = bytesBeforeCut(length);
+  for(size_t i = 0; i < done; i++) {
+    target[i] &= data[i];
+  }
+  if(done < length) {
+    target[done] &= data[done] | random();
+  }
+
+  pagePrograms++;
+  busyUs += NOR_PAGE_PROGRAM_US;
+  return !poweredOff;
+}
+
+void NorFlash::cutPowerAfter(int64_t bytes) {
+  powerBudget = bytes;
+}
+
+void NorFlash::powerOn() {
+  poweredOff = false;
+  powerBudget = -1;
+}
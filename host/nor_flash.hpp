@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+#include <random>
+
+#include "kvstore.hpp"
+
+// Typical figures for the W25Q16JV on the Pico, the datasheet maximums
+// are several times longer
+static const uint32_t NOR_PAGE_PROGRAM_US = 400;
+static const uint32_t NOR_SECTOR_ERASE_US = 45000;
+static const uint32_t NOR_ERASE_ENDURANCE = 100000;
+
+// Byte-accurate model of NOR flash. Erase sets a sector to 0xFF, program
+// can only clear bits within one page, and every operation is counted so
+// a run can be turned into wear and time estimates.
+//
+// Power can be cut after any number of erased or programmed bytes. The
+// operation in flight stops there, an erase leaving the rest of its sector
+// with random bits set and a program leaving its last byte half written.
+// Everything after fails until powerOn().
+class NorFlash : public FlashBackend {
+public:
+  NorFlash(uint32_t size, uint32_t seed = 1);
+
+  const uint8_t* read(uint32_t offset) override;
+  bool erase(uint32_t offset) override;
+  bool program(uint32_t offset, const uint8_t* data, size_t length) override;
+
+  // Bytes to erase or program before power goes, negative for never
+  void cutPowerAfter(int64_t bytes);
+  void powerOn();
+  bool isPoweredOff() const { return poweredOff; }
+
+  std::vector<uint8_t> memory;
+  std::vector<uint32_t> sectorErases;
+
+  uint64_t reads = 0;
+  uint64_t pagePrograms = 0;
+  uint64_t busyUs = 0;
+
+  // Bytes programmed over something they can't be, NOR can only clear bits
+  // and 0xFF is how a page write leaves a byte alone
+  uint64_t overwrites = 0;
+
+private:
+  // How many of `length` bytes get done before power goes
+  size_t bytesBeforeCut(size_t length);
+
+  int64_t powerBudget = -1;
+  bool poweredOff = false;
+  std::mt19937 random;
+};
+
+// The flash PicoFlashBackend lands on in host builds, the whole chip
+extern NorFlash hostFlash;
@@ -0,0 +1,25 @@
+#include "ppm.hpp"
+
+#include <stdio.h>
+
+bool writePPM(const char* path, const PicoGraphics_PenRGB332& graphics) {
+  FILE* file = fopen(path, "wb");
+  if(!file) return false;
+
+  int width = graphics.bounds.w;
+  int height = graphics.bounds.h;
+  fprintf(file, "P6\n%d %d\n255\n", width, height);
+
+  auto pixels = (const uint8_t*)graphics.frame_buffer;
+  for(int i = 0; i < width * height; i++) {
+    uint8_t c = pixels[i];
+    uint8_t rgb[3] = {
+      (uint8_t)(c & 0b11100000),
+      (uint8_t)((c & 0b00011100) << 3),
+      (uint8_t)((c & 0b00000011) << 6),
+    };
+    fwrite(rgb, 1, sizeof(rgb), file);
+  }
+
+  return fclose(file) == 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include "types.hpp"
+
+// Writes an RGB332 framebuffer as a binary PPM, expanding each pixel the
+// same way the display path does
+bool writePPM(const char* path, const PicoGraphics_PenRGB332& graphics);
@@ -0,0 +1,89 @@
+// Plays a recording through the renderers at a fixed frame step and prints
+// one JSON object per frame with its hash and render time, e.g.
+// `jimneyio_replay trail.jrec 33 > run.jsonl`
+//
+// Replay time only moves by the frame step, so the same build always
+// produces the same hashes. Diffing two runs shows which frames a change
+// touched and how their render times moved.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+#include "pico/time.h"
+
+#include "types.hpp"
+#include "pens.hpp"
+#include "environment.hpp"
+#include "inclinometer.hpp"
+#include "ui.hpp"
+#include "recording.hpp"
+#include "replay.hpp"
+
+static bool readFile(const char* path, std::vector<uint8_t>& data) {
+  FILE* f = fopen(path, "rb");
+  if(!f) return false;
+
+  uint8_t buffer[4096];
+  size_t n;
+  while((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+    data.insert(data.end(), buffer, buffer + n);
+  }
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char** argv) {
+  if(argc < 2) {
+    fprintf(stderr, "usage: %s recording.jrec [frame_ms]\n", argv[0]);
+    return 2;
+  }
+  uint32_t frameMs = argc > 2 ? atoi(argv[2]) : 33;
+  if(frameMs == 0) frameMs = 1;
+
+  std::vector<uint8_t> recording;
+  if(!readFile(argv[1], recording)) {
+    fprintf(stderr, "can't read %s\n", argv[1]);
+    return 1;
+  }
+
+  UiState ui;
+  if(!startReplay(recording.data(), recording.size(), ui)) {
+    fprintf(stderr, "%s is not a recording\n", argv[1]);
+    return 1;
+  }
+
+  PicoGraphics_PenRGB332 graphics(WIDTH, HEIGHT, nullptr);
+  Pens pens = initGraphics(graphics);
+  initEnvironment();
+  initInclinometer();
+
+  std::vector<uint32_t> renderTimes;
+  uint32_t timeMs = 0;
+  bool more = true;
+  for(int frame = 0; more; frame++, timeMs += frameMs) {
+    more = advanceReplay(timeMs);
+
+    BUTTON button;
+    while(readReplayButton(button)) {
+      applyButtonPress(ui, button);
+    }
+    updateEnvironment(timeMs / 1000);
+
+    uint64_t start = time_us_64();
+    renderScreen(graphics, pens, ui);
+    uint32_t renderUs = time_us_64() - start;
+    renderTimes.push_back(renderUs);
+
+    uint32_t hash = hashFrame((const uint8_t*)graphics.frame_buffer, WIDTH * HEIGHT);
+    printf("{\"frame\":%d,\"time_ms\":%u,\"mode\":%d,\"hash\":\"%08x\",\"render_us\":%u}\n",
+      frame, timeMs, (int)ui.mode, hash, renderUs);
+  }
+
+  std::sort(renderTimes.begin(), renderTimes.end());
+  size_t count = renderTimes.size();
+  fprintf(stderr, "%zu frames, render median %uus, p99 %uus, max %uus\n", count,
+    renderTimes[count / 2], renderTimes[(count * 99) / 100 < count ? (count * 99) / 100 : count - 1], renderTimes[count - 1]);
+  return 0;
+}
@@ -1,82 +1,68 @@
 #include "inclinometer.hpp"
 #include "jimney.hpp"
+#include "fixed.hpp"
+#include "sensors.hpp"
+#include "recording.hpp"
 
-int testPitch = 0;
-int testRoll = 0;
-const int MAX_TEST_PITCH = 16;
-const int MAX_TEST_ROLL = 5;
-bool isPitchReversing = false;
-bool isRollReversing = false;
+#include <string.h>
+#include <limits.h>
 
 // allows for exagerating changes in pitch and roll for ease of reading
 const int ROLL_SCALING = 2;
 const int PITCH_SCALING = 2;
 
-Orientation generateTestOrientationData() {
-  if(testPitch < MAX_TEST_PITCH && !isPitchReversing) {
-    testPitch += 2;
-    if(testPitch == MAX_TEST_PITCH) isPitchReversing = true;
-  }
-  else if(testPitch > -1*MAX_TEST_PITCH && isPitchReversing) 
-  {
-    testPitch -= 2;
-    if(testPitch == -1*MAX_TEST_PITCH) isPitchReversing = false;
-  }
-
-  if(testRoll < MAX_TEST_ROLL && !isRollReversing) {
-    testRoll += 1;
-    if(testRoll == MAX_TEST_ROLL) isRollReversing = true;
-  }
-  else if(testRoll > -1*MAX_TEST_ROLL && isRollReversing) 
-  {
-    testRoll -= 1;
-    if(testRoll == -1*MAX_TEST_ROLL) isRollReversing = false;
-  }
+// Far enough off either edge to fill the screen with sky or ground at any roll
+const int32_t MIN_HORIZON_Y = -1000;
+const int32_t MAX_HORIZON_Y = HEIGHT + 1000;
 
-  return Orientation(testPitch, testRoll);  
+void initInclinometer() {
+  initMotionSensor();
 }
 
-int orientationSamplesCount = 0;
-float averageRoll = 0;
-float averagePitch = 0; 
-Orientation calculateOrientation() {
-  auto current = generateTestOrientationData();
+// Whole scaled degrees, the finest step the horizon is drawn at
+static Orientation toOrientation(const Attitude& attitude) {
+  return Orientation(
+    q16ToInt(angleToDegrees(attitude.pitch) * PITCH_SCALING),
+    q16ToInt(angleToDegrees(attitude.roll) * ROLL_SCALING));
+}
 
-  if(orientationSamplesCount < 5) {
-    orientationSamplesCount++;
-    averageRoll += current.roll;
-    averageRoll /= orientationSamplesCount;
+// What the last update read for drawing, nothing valid until there's been one
+static Orientation drawnOrientation(INT_MIN, INT_MIN);
 
-    averagePitch += current.pitch;
-    averagePitch /= orientationSamplesCount;
+// The IMU is fused at 200Hz in the background, so this is always the
+// freshest attitude with no extra smoothing on top
+Orientation calculateOrientation() {
+  Attitude attitude;
+  if(!readAttitude(attitude)) {
+    return Orientation(0, 0);
+  }
+  recordAttitude(attitude);
 
-    return Orientation(0,0);
-  } 
+  return toOrientation(attitude);
+}
 
-  averageRoll = averageRoll * 0.8 + current.roll * 0.2;
-  averagePitch = averagePitch * 0.8 + current.pitch * 0.2;
-  return Orientation(
-    averagePitch * PITCH_SCALING,
-    averageRoll * ROLL_SCALING);
+bool isInclinometerStale() {
+  Attitude attitude;
+  Orientation orientation = readAttitude(attitude) ? toOrientation(attitude) : Orientation(0, 0);
+  return orientation.pitch != drawnOrientation.pitch || orientation.roll != drawnOrientation.roll;
 }
 
-Line rotateLine(Line line, float deg) {
-   float theta = deg * M_PI / 180;
-   float cosang = cos(theta);
-   float sinang = sin(theta);
+Line rotateLine(Line line, angle16 a) {
+   int32_t cosang = cosQ15(a);
+   int32_t sinang = sinQ15(a);
    
    auto cx = (line.p1.x + line.p2.x) / 2;
-   auto cy = (line.p1.y + line.p2.y);
+   auto cy = (line.p1.y + line.p2.y) / 2;
   
    auto tx1 = line.p1.x - cx;
    auto ty1 = line.p1.y - cy;
 
-   auto p1 = Point(tx1*cosang + ty1*sinang + cx, -tx1*sinang+ty1*cosang + cy);
+   auto p1 = Point(((tx1*cosang + ty1*sinang) >> 15) + cx, ((-tx1*sinang + ty1*cosang) >> 15) + cy);
 
    auto tx2 = line.p2.x - cx;
    auto ty2 = line.p2.y - cy;
 
-   auto p2 = Point(tx2*cosang + ty2*sinang + cx, -tx2*sinang+ty2*cosang + cy);
+   auto p2 = Point(((tx2*cosang + ty2*sinang) >> 15) + cx, ((-tx2*sinang + ty2*cosang) >> 15) + cy);
 
    return Line(p1, p2);
 }
@@ -99,28 +85,65 @@ Point lineIntersection(Line l1, Line l2)
   return Point(det(d, xDiff) / div, det(d, yDiff) / div);
 }
 
-void renderInclinometerFrame(PicoGraphics& graphics, Pens& pens) {
-
-  auto orientation = calculateOrientation();
+void fillHorizon(PicoGraphics& graphics, Line horizon, Pen ground, Pen sky) {
+  auto frameBuffer = (uint8_t*)graphics.frame_buffer;
+  const Rect& clip = graphics.clip;
+  int32_t clipRight = clip.x + clip.w;
+  int32_t clipBottom = clip.y + clip.h;
+
+  int32_t dx = horizon.p2.x - horizon.p1.x;
+  int32_t dy = horizon.p2.y - horizon.p1.y;
+
+  // Ground is to the right walking from p1 to p2, so once the roll passes
+  // 90 degrees the ground ends up at the top of the screen
+  if(dy == 0) {
+    for(int32_t y = clip.y; y < clipBottom; y++) {
+      bool below = y >= horizon.p1.y;
+      Pen pen = (dx > 0) == below ? ground : sky;
+      memset(frameBuffer + y * graphics.bounds.w + clip.x, pen, clip.w);
+    }
+    return;
+  }
 
-  uint8_t yOffset = 120+orientation.pitch;
+  // Where the horizon crosses the middle of each row, stepped down the rows
+  // in 32.32 so the truncated step can't drift a whole pixel by the bottom
+  int64_t step = ((int64_t)dx << 32) / dy;
+  int64_t crossing = ((int64_t)horizon.p1.x << 32) + (((int64_t)(2 * (clip.y - horizon.p1.y) + 1) * dx) << 31) / dy;
+  Pen left = dy > 0 ? ground : sky;
+  Pen right = dy > 0 ? sky : ground;
+
+  for(int32_t y = clip.y; y < clipBottom; y++, crossing += step) {
+    // First column whose centre is on the right of the horizon
+    int64_t split = (crossing + 0x7FFFFFFF) >> 32;
+    if(split < clip.x) split = clip.x;
+    if(split > clipRight) split = clipRight;
+
+    uint8_t* row = frameBuffer + y * graphics.bounds.w;
+    memset(row + clip.x, left, split - clip.x);
+    memset(row + split, right, clipRight - split);
+  }
+}
 
-  auto line = rotateLine(Line(Point(0, yOffset),Point(240, yOffset)), orientation.roll);
-  auto leftEdgePoint = lineIntersection(line, Line(Point(0,0),Point(0,240)));
-  auto rightEdgePoint =  lineIntersection(line, Line(Point(240, 0), Point(240, 240)));
+void renderInclinometerFrame(PicoGraphics& graphics, Pens& pens) {
+  updateInclinometer();
+  drawInclinometerFrame(graphics, pens);
+}
 
-  graphics.set_pen(pens.SKY_BLUE_DAY);
-  graphics.clear();
+void updateInclinometer() {
+  drawnOrientation = calculateOrientation();
+}
 
-  graphics.set_pen(pens.GRASS_GREEN_DAY);
+void drawInclinometerFrame(PicoGraphics& graphics, Pens& pens) {
+  auto orientation = drawnOrientation;
 
-  std::vector<Point> poly;
-  poly.push_back(leftEdgePoint);
-  poly.push_back(rightEdgePoint);
-  poly.push_back(Point(240,240));
-  poly.push_back(Point(0,240));
+  // Steep pitches put the horizon off the screen, fillHorizon copes with
+  // that as long as the arithmetic stays well inside 32 bits
+  int32_t yOffset = 120 + orientation.pitch;
+  if(yOffset < MIN_HORIZON_Y) yOffset = MIN_HORIZON_Y;
+  if(yOffset > MAX_HORIZON_Y) yOffset = MAX_HORIZON_Y;
 
-  graphics.polygon(poly);
+  auto line = rotateLine(Line(Point(0, yOffset),Point(240, yOffset)), degreesToAngle(toQ16(orientation.roll)));
+  fillHorizon(graphics, line, pens.GRASS_GREEN_DAY, pens.SKY_BLUE_DAY);
 
   Pen cartesianLinesPen = pens.BLACK;
 
@@ -130,5 +153,5 @@ void renderInclinometerFrame(PicoGraphics& graphics, Pens& pens) {
   graphics.line(Point(0, 120), Point(70, 120));
   graphics.line(Point(170, 120), Point(240, 120));
 
-  drawJimny(graphics, pens, 56, 56, DARK);
+  drawJimny(graphics, 56, 56, DARK);
 }
\ No newline at end of file
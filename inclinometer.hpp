@@ -1,5 +1,23 @@
 #pragma once
 
 #include "types.hpp"
+#include "fixed.hpp"
 
-void renderInclinometerFrame(PicoGraphics& graphics, Pens& pens);
\ No newline at end of file
+void initInclinometer();
+void renderInclinometerFrame(PicoGraphics& graphics, Pens& pens);
+
+// renderInclinometerFrame in two halves. The update reads and records the
+// attitude, the draw only uses what the last update read, so it can run
+// on both cores at once.
+void updateInclinometer();
+void drawInclinometerFrame(PicoGraphics& graphics, Pens& pens);
+
+// True once the attitude has moved far enough that a new frame would draw
+// the horizon somewhere else
+bool isInclinometerStale();
+
+Line rotateLine(Line line, angle16 a);
+Point lineIntersection(Line l1, Line l2);
+
+// Paints ground below the horizon and sky above it, one pair of spans per row
+void fillHorizon(PicoGraphics& graphics, Line horizon, Pen ground, Pen sky);
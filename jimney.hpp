@@ -7,4 +7,4 @@ enum JimneyMode {
     LIGHT=1
 };
 
-void drawJimny(PicoGraphics& graphics, Pens& pens, uint8_t offset_x, uint8_t offset_y, JimneyMode mode);
+void drawJimny(PicoGraphics& graphics, uint8_t offset_x, uint8_t offset_y, JimneyMode mode);
@@ -0,0 +1,213 @@
+#include "kvstore.hpp"
+
+#include <string.h>
+
+static const uint8_t SECTOR_MAGIC[4] = {'J', 'K', 'V', '1'};
+static const uint16_t ERASED_KEY = 0xFFFF;
+
+// Slot layouts. Headers are magic(4) generation(4) crc(4), records are
+// key(2) length(1) reserved(1) value(24) crc(4), both padded with 0xFF.
+static const uint32_t HEADER_CRC_OFFSET = 8;
+static const uint32_t RECORD_VALUE_OFFSET = 4;
+static const uint32_t RECORD_CRC_OFFSET = KV_SLOT_SIZE - 4;
+
+uint32_t crc32(const uint8_t* data, size_t length) {
+  uint32_t crc = 0xFFFFFFFF;
+  for(size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for(int bit = 0; bit < 8; bit++) {
+      crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+    }
+  }
+  return ~crc;
+}
+
+static uint32_t getUint32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void putUint32(uint8_t* p, uint32_t value) {
+  for(int i = 0; i < 4; i++) {
+    p[i] = value >> (i * 8);
+  }
+}
+
+static bool isErased(const uint8_t* p, size_t length) {
+  for(size_t i = 0; i < length; i++) {
+    if(p[i] != 0xFF) return false;
+  }
+  return true;
+}
+
+static uint32_t slotOffset(uint32_t sector, uint32_t slot) {
+  return sector * KV_SECTOR_SIZE + slot * KV_SLOT_SIZE;
+}
+
+// Generation of a sector, 0 if it has no valid header
+static uint32_t readGeneration(FlashBackend* flash, uint32_t sector) {
+  const uint8_t* header = flash->read(slotOffset(sector, 0));
+  if(memcmp(header, SECTOR_MAGIC, sizeof(SECTOR_MAGIC)) != 0) return 0;
+  if(crc32(header, HEADER_CRC_OFFSET) != getUint32(header + HEADER_CRC_OFFSET)) return 0;
+  return getUint32(header + 4);
+}
+
+static bool isRecordValid(const uint8_t* record) {
+  uint16_t key = record[0] | (record[1] << 8);
+  return key != ERASED_KEY &&
+    record[2] <= KV_MAX_VALUE &&
+    crc32(record, RECORD_CRC_OFFSET) == getUint32(record + RECORD_CRC_OFFSET);
+}
+
+static uint16_t recordKey(const uint8_t* record) {
+  return record[0] | (record[1] << 8);
+}
+
+static bool writeHeader(FlashBackend* flash, uint32_t sector, uint32_t generation) {
+  uint8_t header[KV_SLOT_SIZE];
+  memset(header, 0xFF, sizeof(header));
+  memcpy(header, SECTOR_MAGIC, sizeof(SECTOR_MAGIC));
+  putUint32(header + 4, generation);
+  putUint32(header + HEADER_CRC_OFFSET, crc32(header, HEADER_CRC_OFFSET));
+  return flash->program(slotOffset(sector, 0), header, sizeof(header));
+}
+
+// Slots are filled in order, so the used ones are a prefix and the first
+// erased slot can be found by bisection
+static uint32_t findFrontier(FlashBackend* flash, uint32_t sector) {
+  uint32_t low = 1, high = KV_SLOTS_PER_SECTOR;
+  while(low < high) {
+    uint32_t mid = (low + high) / 2;
+    if(isErased(flash->read(slotOffset(sector, mid)), KV_SLOT_SIZE)) {
+      high = mid;
+    } else {
+      low = mid + 1;
+    }
+  }
+  return low;
+}
+
+// Newest valid record for `key`, walking back from the frontier through
+// the sectors newest first. Null if there isn't one.
+static const uint8_t* findLatest(const KvStore& store, uint16_t key, uint32_t* foundSector) {
+  uint32_t sector = store.activeSector;
+  uint32_t end = store.frontier;
+
+  for(uint32_t i = 0; i < store.sectorCount; i++) {
+    if(i == 0 || readGeneration(store.flash, sector) != 0) {
+      for(uint32_t slot = end; slot-- > 1;) {
+        const uint8_t* record = store.flash->read(slotOffset(sector, slot));
+        if(recordKey(record) == key && isRecordValid(record)) {
+          if(foundSector) *foundSector = sector;
+          return record;
+        }
+      }
+    }
+
+    sector = (sector + store.sectorCount - 1) % store.sectorCount;
+    end = KV_SLOTS_PER_SECTOR;
+  }
+
+  return nullptr;
+}
+
+static bool appendRecord(KvStore& store, const uint8_t* record) {
+  if(!store.flash->program(slotOffset(store.activeSector, store.frontier), record, KV_SLOT_SIZE)) return false;
+  store.frontier++;
+  return true;
+}
+
+// Copies the records in `sector` that are still current into the active
+// sector, then erases it
+static bool compact(KvStore& store, uint32_t sector) {
+  if(readGeneration(store.flash, sector) != 0) {
+    for(uint32_t slot = 1; slot < KV_SLOTS_PER_SECTOR; slot++) {
+      const uint8_t* record = store.flash->read(slotOffset(sector, slot));
+      if(!isRecordValid(record)) continue;
+
+      uint32_t latestSector;
+      if(findLatest(store, recordKey(record), &latestSector) != record) continue;
+
+      // Read the slot through a copy, the backend may map the same buffer
+      uint8_t copy[KV_SLOT_SIZE];
+      memcpy(copy, record, KV_SLOT_SIZE);
+      if(store.frontier >= KV_SLOTS_PER_SECTOR || !appendRecord(store, copy)) return false;
+    }
+  }
+
+  return store.flash->erase(sector * KV_SECTOR_SIZE);
+}
+
+bool KvStore::mount() {
+  generation = 0;
+  for(uint32_t sector = 0; sector < sectorCount; sector++) {
+    uint32_t g = readGeneration(flash, sector);
+    if(g > generation) {
+      generation = g;
+      activeSector = sector;
+    }
+  }
+  if(generation == 0) return false;
+
+  frontier = findFrontier(flash, activeSector);
+
+  // The sector after the active one is the spare. If it isn't erased a
+  // compaction was cut short, finish it.
+  uint32_t spare = (activeSector + 1) % sectorCount;
+  if(!isErased(flash->read(spare * KV_SECTOR_SIZE), KV_SECTOR_SIZE)) {
+    compact(*this, spare);
+  }
+  return true;
+}
+
+void KvStore::format() {
+  for(uint32_t sector = 0; sector < sectorCount; sector++) {
+    flash->erase(sector * KV_SECTOR_SIZE);
+  }
+
+  activeSector = 0;
+  generation = 1;
+  frontier = 1;
+  writeHeader(flash, activeSector, generation);
+}
+
+int KvStore::get(uint16_t key, uint8_t* value, size_t maxLength) {
+  const uint8_t* record = findLatest(*this, key, nullptr);
+  if(!record || record[2] > maxLength) return -1;
+
+  memcpy(value, record + RECORD_VALUE_OFFSET, record[2]);
+  return record[2];
+}
+
+bool KvStore::put(uint16_t key, const uint8_t* value, size_t length) {
+  if(key == ERASED_KEY || length > KV_MAX_VALUE) return false;
+
+  const uint8_t* existing = findLatest(*this, key, nullptr);
+  if(existing && existing[2] == length && memcmp(existing + RECORD_VALUE_OFFSET, value, length) == 0) {
+    return true;
+  }
+
+  uint8_t record[KV_SLOT_SIZE];
+  memset(record, 0xFF, sizeof(record));
+  record[0] = key;
+  record[1] = key >> 8;
+  record[2] = length;
+  memcpy(record + RECORD_VALUE_OFFSET, value, length);
+  putUint32(record + RECORD_CRC_OFFSET, crc32(record, RECORD_CRC_OFFSET));
+
+  if(frontier >= KV_SLOTS_PER_SECTOR) {
+    // Move onto the spare, then free up the oldest sector as the next one
+    uint32_t next = (activeSector + 1) % sectorCount;
+    if(!writeHeader(flash, next, generation + 1)) return false;
+    activeSector = next;
+    generation++;
+    frontier = 1;
+
+    if(!compact(*this, (activeSector + 1) % sectorCount)) return false;
+  }
+
+  return appendRecord(*this, record);
+}
+
+uint32_t KvStore::usedBytes() const {
+  return activeSector * KV_SECTOR_SIZE + frontier * KV_SLOT_SIZE;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Log-structured key/value store for settings, spread over a few flash
+// sectors so no one sector takes all the erases.
+//
+// Each sector starts with a header slot holding a generation number, then
+// fixed 32 byte record slots filled in order. A record is key, length,
+// value and a CRC. The newest record for a key wins, and position gives
+// the order: later slot, later sector generation.
+//
+// Writes go to the active sector. When it fills, the next sector (always
+// kept erased) takes over, the oldest sector's still-current records are
+// copied forward and then it's erased to become the new spare. Power loss
+// at any point leaves either the old or the new copy readable, and mount()
+// finishes an interrupted compaction.
+
+static const uint32_t KV_SECTOR_SIZE = 4096;
+static const uint32_t KV_PAGE_SIZE = 256;
+static const uint32_t KV_SLOT_SIZE = 32;
+static const uint32_t KV_SLOTS_PER_SECTOR = KV_SECTOR_SIZE / KV_SLOT_SIZE;
+static const uint32_t KV_MAX_VALUE = 24;
+
+// Live keys have to fit in one sector alongside its header
+static const uint32_t KV_MAX_KEYS = KV_SLOTS_PER_SECTOR - 1;
+
+// Flash as the store sees it, offsets are from the start of its region.
+// Follows NOR rules: erase sets a whole sector to 0xFF, program can only
+// clear bits and never crosses a page.
+class FlashBackend {
+public:
+  virtual const uint8_t* read(uint32_t offset) = 0;
+  virtual bool erase(uint32_t offset) = 0;
+  virtual bool program(uint32_t offset, const uint8_t* data, size_t length) = 0;
+};
+
+struct KvStore {
+  FlashBackend* flash;
+  uint32_t sectorCount;
+
+  uint32_t activeSector = 0;
+  uint32_t generation = 0;
+
+  // Next free slot in the active sector
+  uint32_t frontier = 1;
+
+  KvStore(FlashBackend* flash, uint32_t sectorCount) : flash(flash), sectorCount(sectorCount) {}
+
+  // Finds the newest sector and its write frontier. False if there's no
+  // store in flash yet, call format() then.
+  bool mount();
+  void format();
+
+  // Length of the value copied into `value`, or -1 if the key has never
+  // been written or `maxLength` is too short
+  int get(uint16_t key, uint8_t* value, size_t maxLength);
+
+  // Appends a record unless the stored value is already the same
+  bool put(uint16_t key, const uint8_t* value, size_t length);
+
+  // Byte offset of the next write, for the stats overlay
+  uint32_t usedBytes() const;
+};
+
+uint32_t crc32(const uint8_t* data, size_t length);
@@ -1,239 +1,544 @@
 #include <string.h>
 #include <math.h>
-#include <vector>
 #include <cstdlib>
-#include <malloc.h>
+#include <atomic>
 
 #include "types.hpp"
 #include "jimney.hpp"
+#include "pens.hpp"
 #include "inclinometer.hpp"
 #include "environment.hpp"
+#include "sensors.hpp"
+#include "ui.hpp"
+#include "recording.hpp"
 #include "state.hpp"
+#include "damage.hpp"
+#include "display.hpp"
+#include "spsc_queue.hpp"
+#include "heap.hpp"
+#include "trace.hpp"
+#include "metrics.hpp"
+#include "memory.hpp"
+#include "buttons.hpp"
+#include "power.hpp"
+
+#if REPLAY_SENSORS
+#include "replay.hpp"
+#include "replay_data.hpp"
+#endif
 
 #include "pico.h"
 #include "pico/flash.h"
 #include "pico/multicore.h"
+#include "hardware/sync.h"
 
-#include "drivers/button/button.hpp"
 #include "drivers/st7789/st7789.hpp"
 #include "rgbled.hpp"
 
-uint32_t getTotalHeap(void) {
-  extern char __StackLimit, __bss_end__;
-  return &__StackLimit  - &__bss_end__;
-}
+ST7789 st7789(WIDTH, HEIGHT, ROTATE_90, false, get_spi_pins(BG_SPI_FRONT));
 
-uint32_t getFreeHeap(void) {
-  struct mallinfo m = mallinfo();
-  return getTotalHeap() - m.uordblks;
-}
+#ifndef FRAME_BUFFER_COUNT
+#define FRAME_BUFFER_COUNT 2
+#endif
 
-ST7789 st7789(WIDTH, HEIGHT, ROTATE_90, false, get_spi_pins(BG_SPI_FRONT));
-PicoGraphics_PenRGB332 graphicsA(st7789.width, st7789.height, nullptr);
-PicoGraphics_PenRGB332 graphicsB(st7789.width, st7789.height, nullptr);
-Pens graphicsAPens;
-Pens graphicsBPens;
-
-enum GRAPHICS {
-  GRAPHICS_NONE = 0,
-  GRAPHICS_A = 1,
-  GRAPHICS_B = 2,
+struct Frame {
+  PicoGraphics_PenRGB332 graphics;
+  Pens pens;
+  Damage damage;
+  absolute_time_t updateStart;
+  uint16_t number = 0;
+
+#if SPLIT_RENDER
+  // A second view of the same buffer for core1, each core needs its own
+  // clip and pen
+  PicoGraphics_PenRGB332 band;
+
+  // Set by core0 before the frame goes to core1 for its band
+  UiState ui;
+  int splitRow = 0;
+
+  // Written by core1 before it sets bandDone
+  int64_t bandUs = 0;
+  std::atomic<bool> bandDone{false};
+#endif
+
+  Frame() : graphics(WIDTH, HEIGHT, nullptr)
+#if SPLIT_RENDER
+    , band(WIDTH, HEIGHT, graphics.frame_buffer)
+#endif
+  {}
 };
 
-GRAPHICS lastGraphics = GRAPHICS_NONE;
-GRAPHICS currentGraphics = GRAPHICS_NONE;
+Frame frames[FRAME_BUFFER_COUNT];
+
+// Frames move core0 -> core1 through readyFrames and back through freeFrames,
+// only the core holding a frame may touch it
+SpscQueue<Frame*, 4> readyFrames;
+SpscQueue<Frame*, 4> freeFrames;
+
+// Pushing to either queue rings a doorbell, the other core sleeps in WFE
+// until then. The inter-core FIFO can't carry these because
+// flash_safe_execute's lockout owns it.
+static inline void ringDoorbell() {
+  __dsb();
+  __sev();
+}
+
+#if SPLIT_RENDER
+// Frames whose bottom band core1 should draw. Only ever one at a time,
+// core0 waits for it before moving on.
+SpscQueue<Frame*, 2> bandFrames;
+#endif
+
+// Last frame handed to core1, what the panel will show once it catches up
+Frame* lastSubmitted = nullptr;
 
 RGBLED led(6, 7, 8);
 
-Button buttonA(A);
-Button buttonB(B);
-Button buttonX(X);
-Button buttonY(Y);
+// Counts every frame rendered, for matching up the stages in a trace
+uint16_t frameNumber = 0;
+
+// Written by core0
+Histogram loopMetric("loop", "us");
+Histogram renderMetric("render", "us");
+Gauge allocationsMetric("allocs");
+Gauge freeHeapMetric("free_heap", "B");
+Gauge framebuffersMetric("framebuffers", "B");
+Histogram inputLagMetric("input_lag", "us");
+
+// Stack high-water marks take a walk over both stacks
+static const uint32_t MEMORY_METRICS_MS = 1000;
+
+// Written by core1's DMA interrupt
+Histogram displayMetric("display", "us");
+Counter framesSentMetric("frames");
+
+UiState ui;
+
+void renderStats(PicoGraphics& graphics, Pens& pens);
+
+// Everything a frame shows, drawn only within the graphics' clip
+void drawFrame(PicoGraphics& graphics, Pens& pens, const UiState& ui) {
+  drawScreen(graphics, pens, ui);
+
+  // Render Stats
+  if(ui.statsEnabled) {
+    renderStats(graphics, pens);
+  }
+}
+
+#if SPLIT_RENDER
+// Written by core0
+Gauge splitMetric("split_row");
+
+// Written by core1
+Histogram bandMetric("render_band", "us");
+
+// Neither core draws less than this, so the costs per row can always be
+// measured and the split can move back
+static const int MIN_BAND_ROWS = 16;
+
+// Where each screen divides between the cores, core0 draws the rows above
+int splitRows[] = {HEIGHT / 2, HEIGHT / 2, HEIGHT / 2};
+
+// Moves the split towards where both cores would have finished together,
+// going by each band's cost per row last frame. The cost isn't even down
+// the screen, so it only goes a quarter of the way and settles over a few
+// frames.
+void balanceSplit(MODE mode, int64_t topUs, int64_t bandUs) {
+  int split = splitRows[mode];
+  int64_t topPerRow = (topUs << 8) / split;
+  int64_t bandPerRow = (bandUs << 8) / (HEIGHT - split);
+  if(topPerRow + bandPerRow == 0) return;
+
+  int target = HEIGHT * bandPerRow / (topPerRow + bandPerRow);
+  split += (target - split) / 4;
+  if(split < MIN_BAND_ROWS) split = MIN_BAND_ROWS;
+  if(split > HEIGHT - MIN_BAND_ROWS) split = HEIGHT - MIN_BAND_ROWS;
+
+  splitRows[mode] = split;
+  splitMetric.set(split);
+}
 
-int loopTime = 0;
-int frameTime = 0;
-int renderTime = 0;
+// Runs on core1 in between starting scan-outs, the previous frame's DMA
+// interrupts keep going underneath it
+void renderBand(Frame* frame) {
+  traceBegin(TRACE_RENDER, frame->number);
+  auto start = get_absolute_time();
 
-MODE mode = SPLASH;
-UNIT units = CELSIUS;
-bool statsEnabled = false;
+  frame->band.set_clip(Rect(0, frame->splitRow, WIDTH, HEIGHT - frame->splitRow));
+  drawFrame(frame->band, frame->pens, frame->ui);
+
+  frame->bandUs = absolute_time_diff_us(start, get_absolute_time());
+  bandMetric.record(frame->bandUs);
+  traceEnd(TRACE_RENDER, frame->number);
+
+  frame->bandDone.store(true, std::memory_order_release);
+  ringDoorbell();
+}
+#endif
+
+// What the last frame was drawn from, a new one is only worth drawing once
+// something here is out of date
+UiState shownUi;
+bool environmentChanged = false;
+
+// Dimmed, not off, the screen should still be readable at a glance
+static const uint8_t IDLE_BACKLIGHT = 48;
+
+// Longest core0 sleeps with nothing to draw, the deferred state save and the
+// metrics are checked at least this often
+static const uint32_t IDLE_WAKE_MS = 100;
+
+// Runs in core1's DMA interrupt once the whole frame is on the panel
+void frameSent(void* context) {
+  static bool backlightOn = false;
+  Frame* frame = (Frame*)context;
+  displayMetric.record(absolute_time_diff_us(frame->updateStart, get_absolute_time()));
+  framesSentMetric.add();
+  traceEnd(TRACE_DISPLAY_UPDATE, frame->number);
+
+  // Turn on the screen after the first frame is rendered
+  if(!backlightOn) {
+    st7789.set_backlight(255);
+    backlightOn = true;
+  }
+
+  freeFrames.push(frame);
+  ringDoorbell();
+}
 
 void core1_entry() {
   flash_safe_execute_core_init();
-  while (true) {
-    GRAPHICS currentGraphicsSnapshot = currentGraphics;
-    // update screen if the buffer was swapped
-    if(currentGraphicsSnapshot != GRAPHICS_NONE && lastGraphics != currentGraphicsSnapshot) {
-      auto updateStart = get_absolute_time();
-      st7789.update(currentGraphicsSnapshot == GRAPHICS_A ? &graphicsA : &graphicsB);
-      auto updateEnd = get_absolute_time();
-      frameTime = absolute_time_diff_us(updateStart, updateEnd);
-      
-      // Turn on the screen after the first frame is rendered
-      if(lastGraphics == GRAPHICS_NONE) {
-        st7789.set_backlight(255);
-      }
+  initDisplay();
 
-      lastGraphics = currentGraphicsSnapshot;
-    } else {
-      sleep_us(10);
+  Frame* frame;
+  while (true) {
+    if(!isDisplayBusy() && readyFrames.pop(frame)) {
+      frame->updateStart = get_absolute_time();
+      traceBegin(TRACE_DISPLAY_UPDATE, frame->number);
+      updateDisplay(frame->graphics, frame->damage, frameSent, frame);
+      continue;
     }
+#if SPLIT_RENDER
+    // Starting a scan-out only takes a moment, so it goes first and the DMA
+    // interrupts carry on sending it while the band is drawn
+    if(bandFrames.pop(frame)) {
+      renderBand(frame);
+      continue;
+    }
+#endif
+    __wfe();
   }
 }
 
-Pens initGraphics(PicoGraphics& graphics) {
-  Pens pens;
-  pens.BLACK = graphics.create_pen(0, 0, 0);
-  pens.WHITE = graphics.create_pen(255,255,255);
-  pens.YELLOW = graphics.create_pen(242,203,0);
-  pens.LIGHT_BLUE = graphics.create_pen(93, 177, 247);
-
-  pens.SPRITE_TRANSPARENCY_LIGHT = graphics.create_pen(146, 146, 146);
-  pens.SPRITE_TRANSPARENCY_DARK = graphics.create_pen(213,213,213);
-  
-  pens.SKY_BLUE_DAY = graphics.create_pen(139, 214, 245);
-  pens.GRASS_GREEN_DAY = graphics.create_pen(186,234,147);
+// Every frame is back from core1, so nothing is on its way to the panel
+// and a flash write can't stall the display halfway through a frame
+bool isPipelineIdle() {
+  return freeFrames.size() == FRAME_BUFFER_COUNT;
+}
 
-  pens.SKY_BLUE_NIGHT = graphics.create_pen(30, 50, 117);
-  pens.GRASS_GREEN_NIGHT = graphics.create_pen(0,145,104);
+void waitForPipelineIdle() {
+  while(!isPipelineIdle()) {
+    __wfe();
+  }
+}
 
-  graphics.set_font("bitmap8");
-  graphics.set_pen(pens.BLACK);
-  graphics.clear();
-  return pens;  
+// Settled state changes go to flash between frames. If the display never
+// drains by itself the next frame waits for it, which costs one late frame
+// rather than one torn by the flash lockout.
+void commitStateWhenIdle(uint32_t nowMs) {
+  if(!isStateCommitDue(nowMs)) return;
+  if(!isPipelineIdle() && !isStateCommitOverdue(nowMs)) return;
+
+  traceBegin(TRACE_FLASH_SAVE, frameNumber);
+  waitForPipelineIdle();
+  commitState();
+  traceEnd(TRACE_FLASH_SAVE, frameNumber);
 }
 
-void renderSplashFrame(PicoGraphics& graphics, Pens& pens) {
-  graphics.set_pen(pens.BLACK);
-  graphics.clear();
+Frame* acquireFrame() {
+  traceBegin(TRACE_BUFFER_WAIT, frameNumber);
+  Frame* frame;
+  while(!freeFrames.pop(frame)) {
+    __wfe();
+  }
+  traceEnd(TRACE_BUFFER_WAIT, frameNumber);
+  return frame;
+}
 
-  drawJimny(graphics, pens, 56, 40, LIGHT);
+void submitFrame(Frame* frame) {
+  if(lastSubmitted == nullptr) {
+    frame->damage.addAll();
+  } else {
+    diffFrames((uint8_t*)lastSubmitted->graphics.frame_buffer, (uint8_t*)frame->graphics.frame_buffer, frame->damage);
+  }
 
-  graphics.set_pen(pens.WHITE);
-  graphics.text("Jimny I/O", Point(55, 170), WIDTH, 3);
-  graphics.text("(c) 2025 Sunny and Rosita LLC", Point(50, 220), WIDTH, 1);
+  frame->number = frameNumber++;
+  lastSubmitted = frame;
+  readyFrames.push(frame);
+  ringDoorbell();
 }
 
 void renderStats(PicoGraphics& graphics, Pens& pens) {
-  char stringBuffer[128];
-  snprintf(stringBuffer, sizeof(stringBuffer), "C0 %dus, C1 %dus", (int)loopTime, (int)frameTime);
+  char stringBuffer[64];
   Point text_location(0, 0);
   graphics.set_pen(pens.WHITE);
-  graphics.text(stringBuffer, text_location, WIDTH, 2);
-  
-  snprintf(stringBuffer, sizeof(stringBuffer), "REN %dus, FMEM %ldk", (int)renderTime, getFreeHeap()/1024);
-  text_location.y = 24;
-  graphics.text(stringBuffer, text_location, WIDTH, 2);
 
-  snprintf(stringBuffer, sizeof(stringBuffer), "SC %dus, FUB 0x%04X, LE: %d", (int)scanTime, firstUnusedByte, lastError);
-  text_location.y = 48;
-  graphics.text(stringBuffer, text_location, WIDTH, 1);
+  for(Metric* metric = firstMetric(); metric; metric = metric->next) {
+    MetricSnapshot snapshot;
+    metric->read(snapshot);
+    formatMetric(*metric, snapshot, stringBuffer, sizeof(stringBuffer));
+    graphics.text(stringBuffer, text_location, WIDTH, 1);
+    text_location.y += 10;
+  }
 }
 
-void renderFrame(PicoGraphics& graphics, Pens& pens) {
+void renderFrame(Frame* frame) {
+    traceBegin(TRACE_RENDER, frameNumber);
     auto render_start = get_absolute_time();
 
-    switch(mode) {
-      case SPLASH:
-        renderSplashFrame(graphics, pens);
-        break;
-
-      case ENVIRONMENT:
-        renderEnvironmentFrame(graphics, pens, units);
-        break;
-      
-      case INCLINOMETER:
-        renderInclinometerFrame(graphics, pens);
-        break;
-    }
-
-    // Render Stats
-    if(statsEnabled) {
-      renderStats(graphics, pens);
+    updateScreen(ui);
+
+#if SPLIT_RENDER
+    // Core1 draws the rows below the split while this core draws the rest
+    frame->ui = ui;
+    frame->splitRow = splitRows[ui.mode];
+    frame->number = frameNumber;
+    frame->bandDone.store(false, std::memory_order_relaxed);
+    bandFrames.push(frame);
+    ringDoorbell();
+
+    auto top_start = get_absolute_time();
+    frame->graphics.set_clip(Rect(0, 0, WIDTH, frame->splitRow));
+    drawFrame(frame->graphics, frame->pens, ui);
+    frame->graphics.remove_clip();
+    int64_t topUs = absolute_time_diff_us(top_start, get_absolute_time());
+
+    while(!frame->bandDone.load(std::memory_order_acquire)) {
+      __wfe();
     }
+    balanceSplit(ui.mode, topUs, frame->bandUs);
+#else
+    drawFrame(frame->graphics, frame->pens, ui);
+#endif
+    shownUi = ui;
+    environmentChanged = false;
     
     auto render_end = get_absolute_time();
-    renderTime = absolute_time_diff_us(render_start, render_end);
+    renderMetric.record(absolute_time_diff_us(render_start, render_end));
+    traceEnd(TRACE_RENDER, frameNumber);
+}
+
+// Nothing animates, so a frame only differs from the last when the input to
+// it has. The stats change every frame, they keep frames coming while shown.
+bool isFrameNeeded() {
+  if(ui != shownUi || ui.statsEnabled) return true;
+
+  switch(ui.mode) {
+    case ENVIRONMENT:
+      return environmentChanged;
+    case INCLINOMETER:
+      return isInclinometerStale();
+    default:
+      return false;
+  }
+}
+
+// Clock changes wait for the display, a frame mid-transfer would have its
+// SPI divider change under it
+void updatePower(uint32_t nowMs) {
+  POWER_STATE wanted = getWantedPowerState(nowMs);
+  if(wanted == getPowerState()) return;
+
+  waitForPipelineIdle();
+  setPowerState(wanted);
+  st7789.set_backlight(wanted == POWER_IDLE ? IDLE_BACKLIGHT : 255);
+}
+
+// Only the inclinometer uses the IMU. Dimmed, it still moves, just less
+// smoothly.
+void updateMotionRate() {
+  if(ui.mode != INCLINOMETER) {
+    setMotionRate(MOTION_OFF);
+  } else {
+    setMotionRate(getPowerState() == POWER_IDLE ? MOTION_SLOW : MOTION_FULL);
+  }
+}
+
+void pressButton(BUTTON button) {
+  recordButton(button);
+  applyButtonPress(ui, button);
 }
 
 void processInput()
 {
-  if (buttonA.read())
-  {
-    if (mode == ENVIRONMENT)
-    {
-      units = units == CELSIUS ? FAHRENHEIT : CELSIUS;
+  traceBegin(TRACE_INPUT, frameNumber);
+#if REPLAY_SENSORS
+  // Every recorded press counts, or the replay would drift from the recording
+  BUTTON button;
+  while(readReplayButton(button)) {
+    notePowerActivity(to_ms_since_boot(get_absolute_time()));
+    pressButton(button);
+  }
+#else
+  // Releases, long presses and chords are queued too, nothing uses them yet
+  ButtonEvent event;
+  while(readButtonEvent(event)) {
+    if(event.type == BUTTON_PRESS) {
+      inputLagMetric.record(time_us_32() - event.timeUs);
+
+      // A press on a dimmed screen only brightens it, whoever pressed it
+      // couldn't see what it would do
+      if(!notePowerActivity(to_ms_since_boot(get_absolute_time()))) {
+        pressButton(event.button);
+      }
     }
-    mode = ENVIRONMENT;
   }
+#endif
+  traceEnd(TRACE_INPUT, frameNumber);
+}
 
-  if (buttonB.read())
-  {
-    mode = INCLINOMETER;
+#if RECORD_SENSORS
+// Records go out over USB serial as hex lines, tools/recording.py capture
+// turns them back into a .jrec file
+void sendRecording(const uint8_t* data, size_t length) {
+  printf("REC ");
+  for(size_t i = 0; i < length; i++) {
+    printf("%02x", data[i]);
   }
+  printf("\n");
+}
+#endif
 
-  if (buttonX.read())
-  {
-    statsEnabled = true;
-  }
+#if TRACE
+// A loop's worth with room to catch up after a slow one
+static const size_t TRACE_DRAIN_EVENTS = 64;
 
-  if (buttonY.read())
-  {
-    statsEnabled = false;
+// Trace events go out the same way, tools/trace.py capture collects them
+void sendTrace(const uint8_t* data, size_t length) {
+  printf("TRC ");
+  for(size_t i = 0; i < length; i++) {
+    printf("%02x", data[i]);
   }
+  printf("\n");
 }
 
+// Along with the registry once a second, as "MET <json>" lines
+static const uint32_t METRICS_EXPORT_MS = 1000;
+
+void sendMetrics(const char* text) {
+  printf("%s", text);
+}
+#endif
+
 int main() {
+  paintStacks();
   stdio_init_all();
   st7789.set_backlight(0);
   printf("Initializing Jimney I/O");
-  multicore_launch_core1(core1_entry);
   led.set_rgb(0,0,0);
 
-  graphicsAPens = initGraphics(graphicsA);
-  graphicsBPens = initGraphics(graphicsB);
+  // Every buffer starts out free, before core1 becomes the only producer
+  for(auto& frame : frames) {
+    frame.pens = initGraphics(frame.graphics);
+#if SPLIT_RENDER
+    initGraphics(frame.band);
+#endif
+    freeFrames.push(&frame);
+  }
+
+  multicore_launch_core1(core1_entry);
 
   // Render Splash Screen Immediately
-  renderFrame(graphicsA, graphicsAPens);
-  currentGraphics = GRAPHICS_A;
+  Frame* splash = acquireFrame();
+  renderFrame(splash);
+  submitFrame(splash);
   
   // Init Sensors
   initEnvironment();
+  initInclinometer();
+  initButtons();
   State savedState = loadState();
   
-  mode = savedState.getMode();
-  units = savedState.getUnits();
+  ui.mode = savedState.getMode();
+  ui.units = savedState.getUnits();
   
   // Show the pretty splash screen for a bit
   sleep_ms(1000);
 
+#if RECORD_SENSORS
+  startRecording(sendRecording, ui.mode, ui.units);
+#endif
+
+#if REPLAY_SENSORS
+  startReplay(REPLAY_DATA, sizeof(REPLAY_DATA), ui);
+  auto replayStart = get_absolute_time();
+#endif
+
+  // Everything from here on runs out of static storage and the stack
+  sealHeap();
+  freeHeapMetric.set(getSealedFreeHeap());
+  framebuffersMetric.set(FRAME_BUFFER_COUNT * PicoGraphics_PenRGB332::buffer_size(WIDTH, HEIGHT));
+  updateMemoryMetrics();
+  uint32_t lastMemoryMs = to_ms_since_boot(get_absolute_time());
+  initPower(lastMemoryMs);
+
   while(true) {
+    uint32_t allocationsStart = getAllocationCount();
+#if REPLAY_SENSORS
+    advanceReplay(absolute_time_diff_us(replayStart, get_absolute_time()) / 1000);
+#endif
+    uint32_t nowMs = to_ms_since_boot(get_absolute_time());
+    // nowMs wraps after 49 days, the history's clock has to keep counting up
+    uint32_t nowSeconds = to_us_since_boot(get_absolute_time()) / 1000000;
+    environmentChanged |= updateEnvironment(nowSeconds);
+
     processInput();
+    updatePower(nowMs);
+    updateMotionRate();
 
-    // Render Frame on current framebuffer
-    auto time_start = get_absolute_time();
-    switch(currentGraphics) {
-      case GRAPHICS_B:
-        renderFrame(graphicsA, graphicsAPens);
-        break;
-      case GRAPHICS_A:
-        renderFrame(graphicsB, graphicsBPens);
-        break;
-    }
-    
-    // Wait for current frame to finish rendering
-    while(lastGraphics != currentGraphics) {
-      sleep_us(10);
+    saveStateLater(State(ui.mode, ui.units), nowMs);
+    commitStateWhenIdle(nowMs);
+
+    if(nowMs - lastMemoryMs >= MEMORY_METRICS_MS) {
+      lastMemoryMs = nowMs;
+      updateMemoryMetrics();
     }
 
-    // Save state to persistent flash if required
-    saveStateIfNeeded(State(mode, units));
+    if(isFrameNeeded()) {
+      // Render Frame on the oldest buffer core1 has finished with
+      auto time_start = get_absolute_time();
+      Frame* frame = acquireFrame();
+
+      // Presses that came in while waiting for the buffer still make it
+      // into this frame
+      processInput();
+      renderFrame(frame);
 
-    // Signal to render the next frame
-    currentGraphics = currentGraphics == GRAPHICS_A ? GRAPHICS_B : GRAPHICS_A;
+      // Queue the frame for core1 and move straight on to the next one
+      submitFrame(frame);
 
-    auto time_end = get_absolute_time();
-    loopTime = absolute_time_diff_us(time_start, time_end);
+      auto time_end = get_absolute_time();
+      loopMetric.record(absolute_time_diff_us(time_start, time_end));
+      allocationsMetric.set(getAllocationCount() - allocationsStart);
+    } else {
+      // Any interrupt wakes this, a button, a sensor reading or core1
+      // handing a frame back
+      best_effort_wfe_or_timeout(make_timeout_time_ms(IDLE_WAKE_MS));
+    }
+
+#if TRACE
+    drainTrace(sendTrace, TRACE_DRAIN_EVENTS);
+
+    static uint32_t lastMetricsMs = 0;
+    if(nowMs - lastMetricsMs >= METRICS_EXPORT_MS) {
+      lastMetricsMs = nowMs;
+      printf("MET ");
+      writeMetricsJson(sendMetrics);
+      printf("\n");
+    }
+#endif
   }
 
   return 0;
@@ -0,0 +1,79 @@
+#include "memory.hpp"
+#include "heap.hpp"
+#include "metrics.hpp"
+
+#include "pico.h"
+
+static const uint32_t STACK_PAINT = 0xDEADBEEF;
+
+// Room left for paintStacks() itself below the frame it was called from
+static const uint32_t PAINT_MARGIN_WORDS = 32;
+
+extern uint32_t __data_start__, __data_end__;
+extern uint32_t __bss_start__, __bss_end__;
+extern uint32_t __StackLimit;
+extern uint32_t __StackBottom, __StackTop;
+extern uint32_t __StackOneBottom, __StackOneTop;
+
+Gauge ramStaticMetric("ram_static", "B");
+Gauge heapUsedMetric("heap_used", "B");
+Gauge stack0Metric("stack0_peak", "B");
+Gauge stack1Metric("stack1_peak", "B");
+
+static uint32_t* stackBottom(CORE core) {
+  return core == CORE0 ? &__StackBottom : &__StackOneBottom;
+}
+
+static uint32_t* stackTop(CORE core) {
+  return core == CORE0 ? &__StackTop : &__StackOneTop;
+}
+
+void __attribute__((noinline)) paintStacks() {
+  uint32_t here;
+  uint32_t* core0Limit = &here - PAINT_MARGIN_WORDS;
+
+  for(uint32_t* p = &__StackBottom; p < core0Limit; p++) {
+    *p = STACK_PAINT;
+  }
+  for(uint32_t* p = &__StackOneBottom; p < &__StackOneTop; p++) {
+    *p = STACK_PAINT;
+  }
+}
+
+uint32_t getStackSize(CORE core) {
+  return (stackTop(core) - stackBottom(core)) * sizeof(uint32_t);
+}
+
+// Stacks grow down, so the lowest overwritten word is the deepest point
+uint32_t getStackHighWater(CORE core) {
+  uint32_t* p = stackBottom(core);
+  uint32_t* top = stackTop(core);
+  while(p < top && *p == STACK_PAINT) {
+    p++;
+  }
+  return (top - p) * sizeof(uint32_t);
+}
+
+RamLayout getRamLayout() {
+  RamLayout layout;
+  layout.data = (&__data_end__ - &__data_start__) * sizeof(uint32_t);
+  layout.bss = (&__bss_end__ - &__bss_start__) * sizeof(uint32_t);
+  layout.heap = getTotalHeap();
+  layout.stack0 = getStackSize(CORE0);
+  layout.stack1 = getStackSize(CORE1);
+  return layout;
+}
+
+void updateMemoryMetrics() {
+  RamLayout layout = getRamLayout();
+  ramStaticMetric.set(layout.data + layout.bss);
+
+  // The framebuffers and everything else init allocates, the heap never
+  // moves once it's sealed
+  if(isHeapSealed()) {
+    heapUsedMetric.set(layout.heap - getSealedFreeHeap());
+  }
+
+  stack0Metric.set(getStackHighWater(CORE0));
+  stack1Metric.set(getStackHighWater(CORE1));
+}
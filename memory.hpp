@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+// Where the RAM goes, from the linker's symbols. Each core's stack is
+// painted with a pattern at boot, so the deepest either has ever reached
+// is however much of the pattern has been overwritten.
+
+enum CORE {
+  CORE0 = 0,
+  CORE1 = 1
+};
+
+// Call first thing in main, before core1 is launched. Paints core0's stack
+// below the caller and the whole of core1's.
+void paintStacks();
+
+uint32_t getStackSize(CORE core);
+
+// Most bytes of the stack ever in use. Equal to the stack size means it
+// ran past the end at some point.
+uint32_t getStackHighWater(CORE core);
+
+struct RamLayout {
+  uint32_t data;
+  uint32_t bss;
+  uint32_t heap;
+  uint32_t stack0;
+  uint32_t stack1;
+};
+
+RamLayout getRamLayout();
+
+// Publishes the static layout and both stack high-water marks to the
+// metrics registry. Walks both stacks, so once a second is plenty.
+void updateMemoryMetrics();
@@ -0,0 +1,148 @@
+#include "metrics.hpp"
+
+#include <stdio.h>
+#include <inttypes.h>
+
+// Metrics are globals, so these are filled in by static constructors
+// before main runs, one at a time
+static Metric* registryFirst = nullptr;
+static Metric* registryLast = nullptr;
+
+Metric::Metric(const char* name, const char* unit, METRIC_KIND kind, std::atomic<uint32_t>* buckets)
+  : name(name), unit(unit), kind(kind), next(nullptr), buckets(buckets) {
+  if(registryLast) {
+    registryLast->next = this;
+  } else {
+    registryFirst = this;
+  }
+  registryLast = this;
+}
+
+static size_t bucketOf(int32_t value) {
+  if(value <= 0) return 0;
+  size_t bucket = 32 - __builtin_clz((uint32_t)value);
+  return bucket < METRIC_BUCKETS ? bucket : METRIC_BUCKETS - 1;
+}
+
+void Metric::publish(int32_t newValue, uint32_t samples) {
+  uint32_t s = sequence.load(std::memory_order_relaxed);
+  sequence.store(s + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  // Only this writer changes these, so plain loads and stores will do
+  value.store(newValue, std::memory_order_relaxed);
+  if(newValue < min.load(std::memory_order_relaxed)) min.store(newValue, std::memory_order_relaxed);
+  if(newValue > max.load(std::memory_order_relaxed)) max.store(newValue, std::memory_order_relaxed);
+  count.store(count.load(std::memory_order_relaxed) + samples, std::memory_order_relaxed);
+  if(buckets) {
+    auto& bucket = buckets[bucketOf(newValue)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  sequence.store(s + 2, std::memory_order_release);
+}
+
+// Spins while the writer is mid-update, so never call this from an
+// interrupt on the writer's own core
+void Metric::read(MetricSnapshot& snapshot) const {
+  uint32_t before, after;
+  do {
+    before = sequence.load(std::memory_order_acquire);
+
+    snapshot.value = value.load(std::memory_order_relaxed);
+    snapshot.min = min.load(std::memory_order_relaxed);
+    snapshot.max = max.load(std::memory_order_relaxed);
+    snapshot.count = count.load(std::memory_order_relaxed);
+    for(size_t i = 0; i < METRIC_BUCKETS; i++) {
+      snapshot.buckets[i] = buckets ? buckets[i].load(std::memory_order_relaxed) : 0;
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    after = sequence.load(std::memory_order_relaxed);
+  } while((before & 1) || before != after);
+}
+
+void Counter::add(int32_t amount) {
+  total += amount;
+  publish(total, 1);
+}
+
+void Gauge::set(int32_t value) {
+  publish(value, 1);
+}
+
+void Histogram::record(int32_t value) {
+  publish(value, 1);
+}
+
+Metric* firstMetric() {
+  return registryFirst;
+}
+
+int32_t metricPercentile(const MetricSnapshot& snapshot, uint32_t p) {
+  if(snapshot.count == 0) return 0;
+
+  uint64_t target = ((uint64_t)snapshot.count * p + 99) / 100;
+  uint64_t seen = 0;
+  for(size_t i = 0; i < METRIC_BUCKETS - 1; i++) {
+    seen += snapshot.buckets[i];
+    if(seen >= target) return i ? 1 << i : 0;
+  }
+  return snapshot.max;
+}
+
+void formatMetric(const Metric& metric, const MetricSnapshot& snapshot, char* buffer, size_t size) {
+  if(snapshot.count == 0) {
+    snprintf(buffer, size, "%s --", metric.name);
+    return;
+  }
+
+  switch(metric.kind) {
+    case METRIC_COUNTER:
+      snprintf(buffer, size, "%s %" PRId32 "%s", metric.name, snapshot.value, metric.unit);
+      break;
+
+    case METRIC_GAUGE:
+      snprintf(buffer, size, "%s %" PRId32 "%s %" PRId32 "-%" PRId32,
+        metric.name, snapshot.value, metric.unit, snapshot.min, snapshot.max);
+      break;
+
+    case METRIC_HISTOGRAM:
+      snprintf(buffer, size, "%s %" PRId32 "%s %" PRId32 "-%" PRId32 " p99<%" PRId32,
+        metric.name, snapshot.value, metric.unit, snapshot.min, snapshot.max, metricPercentile(snapshot, 99));
+      break;
+  }
+}
+
+void writeMetricsJson(MetricsSink sink) {
+  static const char* KIND_NAMES[] = {"counter", "gauge", "histogram"};
+  char buffer[160];
+
+  sink("{");
+  for(Metric* metric = firstMetric(); metric; metric = metric->next) {
+    MetricSnapshot snapshot;
+    metric->read(snapshot);
+
+    snprintf(buffer, sizeof(buffer),
+      "%s\"%s\":{\"kind\":\"%s\",\"unit\":\"%s\",\"count\":%" PRIu32 ",\"value\":%" PRId32,
+      metric == firstMetric() ? "" : ",", metric->name, KIND_NAMES[metric->kind], metric->unit,
+      snapshot.count, snapshot.value);
+    sink(buffer);
+
+    if(metric->kind != METRIC_COUNTER && snapshot.count > 0) {
+      snprintf(buffer, sizeof(buffer), ",\"min\":%" PRId32 ",\"max\":%" PRId32, snapshot.min, snapshot.max);
+      sink(buffer);
+    }
+
+    if(metric->kind == METRIC_HISTOGRAM) {
+      sink(",\"buckets\":[");
+      for(size_t i = 0; i < METRIC_BUCKETS; i++) {
+        snprintf(buffer, sizeof(buffer), "%s%" PRIu32, i ? "," : "", snapshot.buckets[i]);
+        sink(buffer);
+      }
+      sink("]");
+    }
+    sink("}");
+  }
+  sink("}");
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Counters, gauges and histograms that one core publishes and anything can
+// read. Each metric is a global that links itself into the registry when
+// it's constructed, so the stats overlay and the USB export find every
+// metric without being told about it and nothing touches the heap.
+//
+// A metric has one writer: a core, or an interrupt on that core, never
+// both. Writes go through a seqlock, so a reader on the other core either
+// gets a whole update or tries again, without ever blocking the writer.
+
+enum METRIC_KIND {
+  METRIC_COUNTER,
+  METRIC_GAUGE,
+  METRIC_HISTOGRAM
+};
+
+// Histogram buckets are powers of two, bucket n counts values below 2^n
+static const size_t METRIC_BUCKETS = 20;
+
+struct MetricSnapshot {
+  // Counters: the total. Gauges and histograms: the latest value.
+  int32_t value;
+  int32_t min;
+  int32_t max;
+  uint32_t count;
+  uint32_t buckets[METRIC_BUCKETS];
+};
+
+class Metric {
+public:
+  const char* name;
+  const char* unit;
+  METRIC_KIND kind;
+  Metric* next;
+
+  // Consistent copy of everything published so far. Histogram buckets are
+  // left zero for the other kinds.
+  void read(MetricSnapshot& snapshot) const;
+
+protected:
+  Metric(const char* name, const char* unit, METRIC_KIND kind, std::atomic<uint32_t>* buckets);
+
+  void publish(int32_t value, uint32_t count);
+
+private:
+  // Odd while an update is half written
+  std::atomic<uint32_t> sequence{0};
+  std::atomic<int32_t> value{0};
+  std::atomic<int32_t> min{INT32_MAX};
+  std::atomic<int32_t> max{INT32_MIN};
+  std::atomic<uint32_t> count{0};
+  std::atomic<uint32_t>* buckets;
+};
+
+class Counter : public Metric {
+public:
+  Counter(const char* name, const char* unit = "") : Metric(name, unit, METRIC_COUNTER, nullptr) {}
+  void add(int32_t amount = 1);
+
+private:
+  int32_t total = 0;
+};
+
+class Gauge : public Metric {
+public:
+  Gauge(const char* name, const char* unit = "") : Metric(name, unit, METRIC_GAUGE, nullptr) {}
+  void set(int32_t value);
+};
+
+class Histogram : public Metric {
+public:
+  Histogram(const char* name, const char* unit = "") : Metric(name, unit, METRIC_HISTOGRAM, bucketStorage) {}
+  void record(int32_t value);
+
+private:
+  std::atomic<uint32_t> bucketStorage[METRIC_BUCKETS] = {};
+};
+
+// Every metric, in the order they were constructed
+Metric* firstMetric();
+
+// Upper bound of the bucket holding the p'th percentile, 0 with no samples
+int32_t metricPercentile(const MetricSnapshot& snapshot, uint32_t p);
+
+// One line for the stats overlay, e.g. "render 3104us 2890-41020 p99<4096"
+void formatMetric(const Metric& metric, const MetricSnapshot& snapshot, char* buffer, size_t size);
+
+typedef void (*MetricsSink)(const char* line);
+
+// The whole registry as one JSON object, handed to the sink in pieces
+void writeMetricsJson(MetricsSink sink);
@@ -0,0 +1,20 @@
+#include "pens.hpp"
+
+Pens initGraphics(PicoGraphics& graphics) {
+  Pens pens;
+  pens.BLACK = graphics.create_pen(0, 0, 0);
+  pens.WHITE = graphics.create_pen(255,255,255);
+  pens.YELLOW = graphics.create_pen(242,203,0);
+  pens.LIGHT_BLUE = graphics.create_pen(93, 177, 247);
+
+  pens.SKY_BLUE_DAY = graphics.create_pen(139, 214, 245);
+  pens.GRASS_GREEN_DAY = graphics.create_pen(186,234,147);
+
+  pens.SKY_BLUE_NIGHT = graphics.create_pen(30, 50, 117);
+  pens.GRASS_GREEN_NIGHT = graphics.create_pen(0,145,104);
+
+  graphics.set_font("bitmap8");
+  graphics.set_pen(pens.BLACK);
+  graphics.clear();
+  return pens;  
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "types.hpp"
+
+Pens initGraphics(PicoGraphics& graphics);
@@ -0,0 +1,60 @@
+#include "power.hpp"
+#include "display.hpp"
+#include "sensors.hpp"
+#include "metrics.hpp"
+
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "hardware/uart.h"
+
+Gauge sysClockMetric("sys_clock", "kHz");
+
+static POWER_STATE powerState = POWER_ACTIVE;
+static uint32_t activeClockKhz;
+static uint32_t lastActivityMs;
+
+void initPower(uint32_t nowMs) {
+  activeClockKhz = clock_get_hz(clk_sys) / 1000;
+  lastActivityMs = nowMs;
+  sysClockMetric.set(activeClockKhz);
+}
+
+POWER_STATE getPowerState() {
+  return powerState;
+}
+
+bool notePowerActivity(uint32_t nowMs) {
+  bool wasIdle = powerState == POWER_IDLE && nowMs - lastActivityMs >= IDLE_AFTER_MS;
+  lastActivityMs = nowMs;
+  return wasIdle;
+}
+
+POWER_STATE getWantedPowerState(uint32_t nowMs) {
+  return nowMs - lastActivityMs >= IDLE_AFTER_MS ? POWER_IDLE : POWER_ACTIVE;
+}
+
+// The sensor callbacks run in alarm interrupts on this core, masking them
+// keeps an I2C transfer from starting on a half-switched clock
+static void setSystemClock(uint32_t khz) {
+  uint32_t interrupts = save_and_disable_interrupts();
+
+  // clk_peri follows clk_sys, but the dividers worked out at init from the
+  // old rate aren't touched
+  if(set_sys_clock_khz(khz, false)) {
+    applyDisplayClock();
+    applySensorBusClock();
+#if LIB_PICO_STDIO_UART
+    uart_set_baudrate(uart_default, PICO_DEFAULT_UART_BAUD_RATE);
+#endif
+  }
+
+  restore_interrupts(interrupts);
+  sysClockMetric.set(clock_get_hz(clk_sys) / 1000);
+}
+
+void setPowerState(POWER_STATE state) {
+  if(state == powerState) return;
+  setSystemClock(state == POWER_IDLE ? IDLE_CLOCK_KHZ : activeClockKhz);
+  powerState = state;
+}
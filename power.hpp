@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stdint.h>
+
+// Full speed while someone is using it. Once the buttons have been left
+// alone for IDLE_AFTER_MS the system clock drops, and the main loop dims the
+// backlight. Frames are only drawn when something changes either way, so
+// idle mostly means the cores sleep longer between interrupts.
+
+enum POWER_STATE {
+  POWER_ACTIVE,
+  POWER_IDLE
+};
+
+static const uint32_t IDLE_AFTER_MS = 5 * 60 * 1000;
+
+// Plenty for the sensors and a frame now and then, and a multiple of 12MHz
+// so the PLL can hit it exactly
+static const uint32_t IDLE_CLOCK_KHZ = 48000;
+
+// Takes whatever clk_sys is at boot as the active speed
+void initPower(uint32_t nowMs);
+
+POWER_STATE getPowerState();
+
+// Pushes idle back. True if it was idle, the first press after a while
+// only wakes the screen up.
+bool notePowerActivity(uint32_t nowMs);
+
+// What the state should be by now, see setPowerState
+POWER_STATE getWantedPowerState(uint32_t nowMs);
+
+// Switches the system clock and re-derives every bus divider from it. The
+// display must be idle, nothing may be sending frames or reading sensors
+// halfway through.
+void setPowerState(POWER_STATE state);
@@ -0,0 +1,165 @@
+#include "recording.hpp"
+
+#include <string.h>
+
+#include "pico/time.h"
+
+static const uint8_t RECORDING_MAGIC[4] = {'J', 'R', 'E', 'C'};
+static const size_t ENVIRONMENT_PAYLOAD = 17;
+static const size_t ATTITUDE_PAYLOAD = 4;
+static const size_t BUTTON_PAYLOAD = 1;
+
+static RecordingSink recordingSink = nullptr;
+static absolute_time_t recordingStart;
+
+static void putUint16(uint8_t* p, uint16_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+}
+
+static void putUint32(uint8_t* p, uint32_t value) {
+  for(int i = 0; i < 4; i++) {
+    p[i] = value >> (i * 8);
+  }
+}
+
+static uint16_t getUint16(const uint8_t* p) {
+  return p[0] | (p[1] << 8);
+}
+
+static uint32_t getUint32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Both ends are little endian, floats go over as their bytes
+static void putFloat(uint8_t* p, float value) {
+  memcpy(p, &value, 4);
+}
+
+static float getFloat(const uint8_t* p) {
+  float value;
+  memcpy(&value, p, 4);
+  return value;
+}
+
+void startRecording(RecordingSink sink, MODE mode, UNIT units) {
+  uint8_t header[RECORDING_HEADER_SIZE] = {0};
+  memcpy(header, RECORDING_MAGIC, sizeof(RECORDING_MAGIC));
+  header[4] = RECORDING_VERSION;
+  header[5] = mode;
+  header[6] = units;
+
+  recordingSink = sink;
+  recordingStart = get_absolute_time();
+  sink(header, sizeof(header));
+}
+
+void stopRecording() {
+  recordingSink = nullptr;
+}
+
+bool isRecording() {
+  return recordingSink != nullptr;
+}
+
+static void writeRecord(RECORD_TYPE type, const uint8_t* payload, uint8_t length) {
+  uint8_t record[RECORD_HEADER_SIZE + ENVIRONMENT_PAYLOAD];
+  putUint32(record, absolute_time_diff_us(recordingStart, get_absolute_time()) / 1000);
+  record[4] = type;
+  record[5] = length;
+  memcpy(record + RECORD_HEADER_SIZE, payload, length);
+  recordingSink(record, RECORD_HEADER_SIZE + length);
+}
+
+void recordEnvironment(const EnvironmentSample& sample) {
+  if(!recordingSink) return;
+
+  uint8_t payload[ENVIRONMENT_PAYLOAD];
+  putFloat(payload, sample.temperature);
+  putFloat(payload + 4, sample.pressure);
+  putFloat(payload + 8, sample.humidity);
+  putFloat(payload + 12, sample.gasResistance);
+  payload[16] = sample.heatStable;
+  writeRecord(RECORD_ENVIRONMENT, payload, sizeof(payload));
+}
+
+void recordAttitude(const Attitude& attitude) {
+  if(!recordingSink) return;
+
+  uint8_t payload[ATTITUDE_PAYLOAD];
+  putUint16(payload, attitude.pitch);
+  putUint16(payload + 2, attitude.roll);
+  writeRecord(RECORD_ATTITUDE, payload, sizeof(payload));
+}
+
+void recordButton(BUTTON button) {
+  if(!recordingSink) return;
+
+  uint8_t payload[BUTTON_PAYLOAD] = {(uint8_t)button};
+  writeRecord(RECORD_BUTTON, payload, sizeof(payload));
+}
+
+bool RecordingReader::open(const uint8_t* data, size_t size) {
+  this->data = data;
+  this->size = size;
+  offset = RECORDING_HEADER_SIZE;
+
+  if(size < RECORDING_HEADER_SIZE ||
+    memcmp(data, RECORDING_MAGIC, sizeof(RECORDING_MAGIC)) != 0 ||
+    data[4] > RECORDING_VERSION) {
+    return false;
+  }
+
+  mode = data[5] <= INCLINOMETER ? (MODE)data[5] : ENVIRONMENT;
+  units = data[6] <= FAHRENHEIT ? (UNIT)data[6] : CELSIUS;
+  return true;
+}
+
+void RecordingReader::rewind() {
+  offset = RECORDING_HEADER_SIZE;
+}
+
+bool RecordingReader::next(Record& record) {
+  while(offset + RECORD_HEADER_SIZE <= size) {
+    const uint8_t* p = data + offset;
+    uint8_t length = p[5];
+    if(offset + RECORD_HEADER_SIZE + length > size) return false;
+
+    offset += RECORD_HEADER_SIZE + length;
+    record.timeMs = getUint32(p);
+    record.type = (RECORD_TYPE)p[4];
+    const uint8_t* payload = p + RECORD_HEADER_SIZE;
+
+    switch(record.type) {
+      case RECORD_ENVIRONMENT:
+        if(length < ENVIRONMENT_PAYLOAD) continue;
+        record.environment.temperature = getFloat(payload);
+        record.environment.pressure = getFloat(payload + 4);
+        record.environment.humidity = getFloat(payload + 8);
+        record.environment.gasResistance = getFloat(payload + 12);
+        record.environment.heatStable = payload[16];
+        return true;
+
+      case RECORD_ATTITUDE:
+        if(length < ATTITUDE_PAYLOAD) continue;
+        record.attitude.pitch = getUint16(payload);
+        record.attitude.roll = getUint16(payload + 2);
+        return true;
+
+      case RECORD_BUTTON:
+        if(length < BUTTON_PAYLOAD || payload[0] > BUTTON_Y) continue;
+        record.button = (BUTTON)payload[0];
+        return true;
+    }
+  }
+
+  return false;
+}
+
+uint32_t hashFrame(const uint8_t* pixels, size_t length) {
+  uint32_t hash = 2166136261u;
+  for(size_t i = 0; i < length; i++) {
+    hash = (hash ^ pixels[i]) * 16777619u;
+  }
+  return hash;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "types.hpp"
+#include "sensors.hpp"
+
+// Sensor and button recordings, for replaying a trail run at the desk.
+// A header then a run of records, all little endian:
+//
+//   header  "JREC" version(1) mode(1) units(1) reserved(1)
+//   record  timeMs(4) type(1) length(1) payload(length)
+//
+// mode and units are the screen at the start, so button presses replay
+// onto the same screens. timeMs counts from the start of the recording.
+// Readers skip types they don't know using the length.
+
+static const uint8_t RECORDING_VERSION = 1;
+static const size_t RECORDING_HEADER_SIZE = 8;
+static const size_t RECORD_HEADER_SIZE = 6;
+
+enum RECORD_TYPE {
+  // temperature, pressure, humidity, gasResistance as floats, heatStable
+  RECORD_ENVIRONMENT = 1,
+  // pitch, roll as angle16
+  RECORD_ATTITUDE = 2,
+  // BUTTON that was pressed
+  RECORD_BUTTON = 3
+};
+
+struct Record {
+  uint32_t timeMs;
+  RECORD_TYPE type;
+  EnvironmentSample environment;
+  Attitude attitude;
+  BUTTON button;
+};
+
+typedef void (*RecordingSink)(const uint8_t* data, size_t length);
+
+// Sends the header, then every record* call until stopRecording()
+void startRecording(RecordingSink sink, MODE mode, UNIT units);
+void stopRecording();
+bool isRecording();
+
+// No-ops unless a recording is running
+void recordEnvironment(const EnvironmentSample& sample);
+void recordAttitude(const Attitude& attitude);
+void recordButton(BUTTON button);
+
+struct RecordingReader {
+  const uint8_t* data = nullptr;
+  size_t size = 0;
+  size_t offset = 0;
+  MODE mode = ENVIRONMENT;
+  UNIT units = CELSIUS;
+
+  // False if the header is missing or from a newer version
+  bool open(const uint8_t* data, size_t size);
+  void rewind();
+
+  // False at the end, or at a truncated record
+  bool next(Record& record);
+};
+
+// FNV-1a over the framebuffer, to compare frames between runs
+uint32_t hashFrame(const uint8_t* pixels, size_t length);
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "types.hpp"
+#include "ui.hpp"
+
+// Plays a recording back through the sensor interface in sensors.hpp.
+// Link replay_sensors.cpp in place of the real (or host) sensors.
+
+// Puts `ui` on the screen the recording started on. False if the data
+// isn't a recording this build can read.
+bool startReplay(const uint8_t* data, size_t size, UiState& ui);
+
+// Releases every record up to `timeMs` into the replayed sensors and
+// buttons. Time is whatever the caller says it is, so a host run can step
+// it a fixed amount per frame and come out the same every time. Returns
+// false once the whole recording has been released.
+bool advanceReplay(uint32_t timeMs);
+
+// Next recorded button press that's due, in order
+bool readReplayButton(BUTTON& button);
@@ -0,0 +1,70 @@
+#include "replay.hpp"
+#include "recording.hpp"
+#include "sensors.hpp"
+#include "spsc_queue.hpp"
+
+static RecordingReader replayReader;
+static bool replayHasPending = false;
+static Record replayPending;
+
+static SpscQueue<EnvironmentSample, 8> replaySamples;
+static SpscQueue<BUTTON, 8> replayButtons;
+static Attitude replayAttitude = {0, 0};
+static bool replayAttitudeAvailable = false;
+
+bool startReplay(const uint8_t* data, size_t size, UiState& ui) {
+  if(!replayReader.open(data, size)) return false;
+
+  ui.mode = replayReader.mode;
+  ui.units = replayReader.units;
+  replayHasPending = replayReader.next(replayPending);
+  return true;
+}
+
+bool advanceReplay(uint32_t timeMs) {
+  while(replayHasPending && replayPending.timeMs <= timeMs) {
+    switch(replayPending.type) {
+      case RECORD_ENVIRONMENT:
+        replaySamples.push(replayPending.environment);
+        break;
+
+      case RECORD_ATTITUDE:
+        replayAttitude = replayPending.attitude;
+        replayAttitudeAvailable = true;
+        break;
+
+      case RECORD_BUTTON:
+        replayButtons.push(replayPending.button);
+        break;
+    }
+
+    replayHasPending = replayReader.next(replayPending);
+  }
+
+  return replayHasPending;
+}
+
+bool readReplayButton(BUTTON& button) {
+  return replayButtons.pop(button);
+}
+
+void initEnvironmentSensor() {
+}
+
+bool readEnvironmentSample(EnvironmentSample& sample) {
+  return replaySamples.pop(sample);
+}
+
+void initMotionSensor() {
+}
+
+bool readAttitude(Attitude& attitude) {
+  attitude = replayAttitude;
+  return replayAttitudeAvailable;
+}
+
+void setMotionRate(MOTION_RATE rate) {
+}
+
+void applySensorBusClock() {
+}
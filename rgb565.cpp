@@ -0,0 +1,24 @@
+#include "rgb565.hpp"
+
+struct RGB565Lut {
+  uint16_t values[256];
+
+  constexpr RGB565Lut() : values() {
+    for(int c = 0; c < 256; c++) {
+      uint16_t r = c & 0b11100000;
+      uint16_t g = (c & 0b00011100) << 3;
+      uint16_t b = (c & 0b00000011) << 6;
+      uint16_t p = ((r & 0b11111000) << 8) | ((g & 0b11111100) << 3) | ((b & 0b11111000) >> 3);
+      values[c] = (p >> 8) | (p << 8);
+    }
+  }
+};
+
+// Not const so it is copied to RAM, the lookup is on the hot path
+static RGB565Lut lut = RGB565Lut();
+
+void convertRGB332Span(const uint8_t* src, uint16_t* dst, size_t count) {
+  for(size_t i = 0; i < count; i++) {
+    dst[i] = lut.values[src[i]];
+  }
+}
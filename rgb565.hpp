@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Converts RGB332 framebuffer pixels to RGB565 in the byte order the
+// ST7789 expects on the wire, matching PicoGraphics_PenRGB332::frame_convert
+void convertRGB332Span(const uint8_t* src, uint16_t* dst, size_t count);
@@ -0,0 +1,301 @@
+#include "sensors.hpp"
+#include "spsc_queue.hpp"
+#include "fusion.hpp"
+#include "trace.hpp"
+
+#include <atomic>
+#include "drivers/bme68x/bme68x.hpp"
+#include "common/pimoroni_i2c.hpp"
+
+#include "pico/time.h"
+
+using namespace pimoroni;
+
+// Start of one measurement to the start of the next
+static const int64_t SAMPLE_INTERVAL_US = 1000 * 1000;
+
+// Recheck this often if the heater has finished but the data isn't ready
+static const int64_t POLL_RETRY_US = 5 * 1000;
+
+static const uint16_t HEATER_TEMPERATURE = 300; // °C
+static const uint16_t HEATER_DURATION = 100; // ms
+
+// Shared by both sensors. Everything after the BME68X's own setup, the
+// IMU probe included, happens in callbacks on the default alarm pool. Those
+// run one at a time, so the bus needs no lock.
+I2C i2c(BOARD::BREAKOUT_GARDEN);
+
+// add_alarm_in_us(0, ...) can run the callback straight away on the calling
+// thread, where an alarm could interrupt it mid-transfer. This always hands
+// it to the alarm interrupt.
+static void runInAlarm(alarm_callback_t callback, void* userData) {
+  alarm_pool_add_alarm_at_force_in_context(alarm_pool_get_default(), get_absolute_time(), callback, userData);
+}
+
+// The pimoroni driver only has a blocking read_forced(), which sleeps
+// through the whole heater cycle. Drive the Bosch API directly instead,
+// borrowing the driver's I2C bindings.
+static BME68X::i2c_intf_ptr interface = {&i2c, BME68X::ALTERNATE_I2C_ADDRESS};
+static bme68x_dev device;
+static bme68x_conf conf;
+static bme68x_heatr_conf heaterConf;
+
+enum SensorState {
+  TRIGGER,
+  FETCH
+};
+
+static SensorState state = TRIGGER;
+static absolute_time_t measurementStart;
+
+// Filled from the alarm interrupt, drained by the renderer
+static SpscQueue<EnvironmentSample, 8> samples;
+
+static bool isDataReady() {
+  uint8_t status;
+  if(bme68x_get_regs(BME68X_REG_FIELD0, &status, 1, &device) != BME68X_OK) return false;
+  return status & BME68X_NEW_DATA_MSK;
+}
+
+static void publishSample(const bme68x_data& data) {
+  EnvironmentSample sample;
+  sample.temperature = data.temperature;
+  sample.pressure = data.pressure;
+  sample.humidity = data.humidity;
+  sample.gasResistance = data.gas_resistance;
+  sample.heatStable = data.status & BME68X_HEAT_STAB_MSK;
+
+  // A full queue means nobody is reading, dropping the newest is fine
+  samples.push(sample);
+}
+
+// Each step does a few I2C transfers and returns how long until the sensor
+// needs attention again
+static int64_t stepSensor() {
+  switch(state) {
+    case TRIGGER: {
+      measurementStart = get_absolute_time();
+      if(bme68x_set_op_mode(BME68X_FORCED_MODE, &device) != BME68X_OK) {
+        return SAMPLE_INTERVAL_US;
+      }
+
+      state = FETCH;
+      return bme68x_get_meas_dur(BME68X_FORCED_MODE, &conf, &device) + HEATER_DURATION * 1000;
+    }
+
+    case FETCH: {
+      int64_t elapsed = absolute_time_diff_us(measurementStart, get_absolute_time());
+
+      // bme68x_get_data() sleeps and retries when data isn't ready, so
+      // check the flag first and come back later rather than block here
+      if(!isDataReady()) {
+        if(elapsed < SAMPLE_INTERVAL_US) {
+          return POLL_RETRY_US;
+        }
+
+        // Given up on this one, start the next measurement instead
+        state = TRIGGER;
+        return POLL_RETRY_US;
+      }
+
+      bme68x_data data;
+      uint8_t fields = 0;
+      if(bme68x_get_data(BME68X_FORCED_MODE, &data, &fields, &device) == BME68X_OK && fields > 0) {
+        publishSample(data);
+      }
+
+      state = TRIGGER;
+      elapsed = absolute_time_diff_us(measurementStart, get_absolute_time());
+      return elapsed < SAMPLE_INTERVAL_US ? SAMPLE_INTERVAL_US - elapsed : POLL_RETRY_US;
+    }
+  }
+
+  return 0;
+}
+
+static int64_t sensorAlarm(alarm_id_t id, void* userData) {
+  traceBegin(TRACE_SENSOR_READ);
+  int64_t next = stepSensor();
+  traceEnd(TRACE_SENSOR_READ);
+  return next;
+}
+
+void initEnvironmentSensor() {
+  device.intf = BME68X_I2C_INTF;
+  device.intf_ptr = &interface;
+  device.read = (bme68x_read_fptr_t)&BME68X::read_bytes;
+  device.write = (bme68x_write_fptr_t)&BME68X::write_bytes;
+  device.delay_us = (bme68x_delay_us_fptr_t)&BME68X::delay_us;
+  device.amb_temp = 20;
+
+  if(bme68x_init(&device) != BME68X_OK) return;
+
+  // Same oversampling as BME68X::init()
+  bme68x_get_conf(&conf, &device);
+  conf.filter = BME68X_FILTER_OFF;
+  conf.odr = BME68X_ODR_NONE;
+  conf.os_hum = BME68X_OS_16X;
+  conf.os_pres = BME68X_OS_1X;
+  conf.os_temp = BME68X_OS_2X;
+  if(bme68x_set_conf(&conf, &device) != BME68X_OK) return;
+
+  // The heater profile persists in the sensor between forced measurements
+  heaterConf.enable = BME68X_ENABLE;
+  heaterConf.heatr_temp = HEATER_TEMPERATURE;
+  heaterConf.heatr_dur = HEATER_DURATION;
+  if(bme68x_set_heatr_conf(BME68X_FORCED_MODE, &heaterConf, &device) != BME68X_OK) return;
+
+  runInAlarm(sensorAlarm, nullptr);
+}
+
+bool readEnvironmentSample(EnvironmentSample& sample) {
+  return samples.pop(sample);
+}
+
+// LSM6DS3 6DoF breakout, polled for the inclinometer
+
+static const uint8_t LSM6DS3_ADDRESS = 0x6A;
+static const uint8_t LSM6DS3_WHO_AM_I = 0x0F;
+static const uint8_t LSM6DS3_CTRL1_XL = 0x10;
+static const uint8_t LSM6DS3_CTRL2_G = 0x11;
+static const uint8_t LSM6DS3_CTRL3_C = 0x12;
+static const uint8_t LSM6DS3_OUTX_L_G = 0x22;
+
+// Accelerometer at +-2g, gyro at +-500dps, output rate to suit how often
+// they're read
+static const uint8_t LSM6DS3_ODR_POWER_DOWN = 0x00;
+static const uint8_t LSM6DS3_ODR_52HZ = 0x30;
+static const uint8_t LSM6DS3_ODR_416HZ = 0x60;
+static const uint8_t LSM6DS3_XL_FS_2G = 0x00;
+static const uint8_t LSM6DS3_G_FS_500DPS = 0x04;
+
+// Block data update so a burst never mixes two samples, and register
+// auto-increment for the burst itself
+static const uint8_t LSM6DS3_BDU_IF_INC = 0x44;
+
+// 0.061mg and 17.5mdps per count at those ranges. The gyro scale is
+// 0.0175 / 360 * 2^32 in angle32 per second.
+static const int32_t ACCEL_ONE_G = 16393;
+static const int32_t GYRO_SCALE = 208783;
+
+struct MotionRateConfig {
+  uint8_t odr;
+  int64_t intervalUs;
+};
+
+// Indexed by MOTION_RATE
+static const MotionRateConfig MOTION_RATES[] = {
+  {LSM6DS3_ODR_POWER_DOWN, 0},
+  {LSM6DS3_ODR_52HZ, 40000},
+  {LSM6DS3_ODR_416HZ, 5000},
+};
+
+static AttitudeFilter attitudeFilter(ACCEL_ONE_G, GYRO_SCALE);
+static repeating_timer motionTimer;
+static uint32_t lastMotionUs;
+
+// Only touched from the alarm callbacks
+static MOTION_RATE motionRate = MOTION_OFF;
+static bool motionPresent = false;
+
+// Set by setMotionRate, applied by whichever alarm callback runs next
+static std::atomic<MOTION_RATE> requestedMotionRate{MOTION_FULL};
+
+// Pitch in the top half, roll in the bottom, so one store publishes both
+static std::atomic<uint32_t> latestAttitude{0};
+static volatile bool motionAvailable = false;
+
+static bool readImu(ImuReading& reading) {
+  // Gyro then accelerometer, x/y/z little endian
+  uint8_t buffer[12];
+  if(i2c.read_bytes(LSM6DS3_ADDRESS, LSM6DS3_OUTX_L_G, buffer, sizeof(buffer)) != sizeof(buffer)) return false;
+
+  for(int i = 0; i < 3; i++) {
+    reading.gyro[i] = (int16_t)(buffer[i * 2] | (buffer[i * 2 + 1] << 8));
+    reading.accel[i] = (int16_t)(buffer[6 + i * 2] | (buffer[6 + i * 2 + 1] << 8));
+  }
+  return true;
+}
+
+static bool motionTimerCallback(repeating_timer* timer) {
+  uint32_t now = time_us_32();
+  uint32_t dtUs = now - lastMotionUs;
+  lastMotionUs = now;
+
+  traceBegin(TRACE_SENSOR_READ);
+  ImuReading reading;
+  if(readImu(reading)) {
+    attitudeFilter.update(reading, dtUs);
+    latestAttitude.store(((uint32_t)toAngle16(attitudeFilter.pitch) << 16) | toAngle16(attitudeFilter.roll), std::memory_order_relaxed);
+    motionAvailable = true;
+  }
+  traceEnd(TRACE_SENSOR_READ);
+  return true;
+}
+
+static void applyMotionRate(MOTION_RATE rate) {
+  if(motionRate != MOTION_OFF) {
+    cancel_repeating_timer(&motionTimer);
+  }
+
+  const MotionRateConfig& config = MOTION_RATES[rate];
+  i2c.reg_write_uint8(LSM6DS3_ADDRESS, LSM6DS3_CTRL1_XL, config.odr | LSM6DS3_XL_FS_2G);
+  i2c.reg_write_uint8(LSM6DS3_ADDRESS, LSM6DS3_CTRL2_G, config.odr | LSM6DS3_G_FS_500DPS);
+
+  if(rate != MOTION_OFF) {
+    // Whatever it was doing before the gap has drifted since
+    if(motionRate == MOTION_OFF) {
+      attitudeFilter.reseed();
+    }
+    lastMotionUs = time_us_32();
+
+    // Negative so the interval runs start to start, however long the read takes
+    add_repeating_timer_us(-config.intervalUs, motionTimerCallback, nullptr, &motionTimer);
+  }
+
+  motionRate = rate;
+}
+
+static int64_t motionRateAlarm(alarm_id_t id, void* userData) {
+  MOTION_RATE rate = requestedMotionRate.load(std::memory_order_relaxed);
+  if(motionPresent && rate != motionRate) {
+    applyMotionRate(rate);
+  }
+  return 0;
+}
+
+static int64_t motionProbeAlarm(alarm_id_t id, void* userData) {
+  uint8_t whoAmI = i2c.reg_read_uint8(LSM6DS3_ADDRESS, LSM6DS3_WHO_AM_I);
+
+  // 0x69 is the LSM6DS3, 0x6A the LSM6DS3TR-C, same registers for this
+  if(whoAmI != 0x69 && whoAmI != 0x6A) return 0;
+
+  i2c.reg_write_uint8(LSM6DS3_ADDRESS, LSM6DS3_CTRL3_C, LSM6DS3_BDU_IF_INC);
+
+  motionPresent = true;
+  return motionRateAlarm(id, userData);
+}
+
+// The bus belongs to the alarm callbacks, so the probe happens in one
+void initMotionSensor() {
+  runInAlarm(motionProbeAlarm, nullptr);
+}
+
+// Likewise the switch. Only the latest request matters, so it doesn't
+// matter which order the callbacks run in.
+void setMotionRate(MOTION_RATE rate) {
+  if(requestedMotionRate.exchange(rate, std::memory_order_relaxed) == rate) return;
+
+  runInAlarm(motionRateAlarm, nullptr);
+}
+
+bool readAttitude(Attitude& attitude) {
+  uint32_t packed = latestAttitude.load(std::memory_order_relaxed);
+  attitude.pitch = packed >> 16;
+  attitude.roll = packed & 0xFFFF;
+  return motionAvailable;
+}
+
+void applySensorBusClock() {
+  i2c_set_baudrate(i2c.get_i2c(), i2c.get_baudrate());
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "fixed.hpp"
+
+struct EnvironmentSample {
+  float temperature;
+  float pressure;
+  float humidity;
+  float gasResistance;
+
+  // Readings are only meaningful once the gas heater has stabilised
+  bool heatStable;
+};
+
+// Starts sampling in the background, one measurement a second
+void initEnvironmentSensor();
+
+// Never blocks, pops the oldest completed sample if there is one
+bool readEnvironmentSample(EnvironmentSample& sample);
+
+
+// Attitude relative to level, nose up and right side down are positive
+struct Attitude {
+  angle16 pitch;
+  angle16 roll;
+};
+
+// Starts polling and fusing the IMU in the background at 200Hz
+void initMotionSensor();
+
+// Latest fused attitude, false until the IMU has produced one
+bool readAttitude(Attitude& attitude);
+
+enum MOTION_RATE {
+  // IMU powered down, the last attitude stays put
+  MOTION_OFF,
+  // 25Hz, enough to keep a dimmed inclinometer moving
+  MOTION_SLOW,
+  // 200Hz
+  MOTION_FULL
+};
+
+// Changes how often the IMU is read, starting at MOTION_FULL. Coming back
+// from MOTION_OFF re-seeds the attitude from the accelerometer.
+void setMotionRate(MOTION_RATE rate);
+
+
+// The I2C divider is worked out from clk_peri, call after changing the
+// system clock. Not while a sensor callback could be running.
+void applySensorBusClock();
@@ -0,0 +1,13 @@
+#include "splash.hpp"
+#include "jimney.hpp"
+
+void renderSplashFrame(PicoGraphics& graphics, Pens& pens) {
+  graphics.set_pen(pens.BLACK);
+  graphics.clear();
+
+  drawJimny(graphics, 56, 40, LIGHT);
+
+  graphics.set_pen(pens.WHITE);
+  graphics.text("Jimny I/O", Point(55, 170), WIDTH, 3);
+  graphics.text("(c) 2025 Sunny and Rosita LLC", Point(50, 220), WIDTH, 1);
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+#include "types.hpp"
+
+void renderSplashFrame(PicoGraphics& graphics, Pens& pens);
@@ -0,0 +1,48 @@
+#include "sprite.hpp"
+
+#include <string.h>
+
+static const uint8_t PACKET_FILL = 0x80;
+static const uint8_t PACKET_LENGTH_MASK = 0x7F;
+
+void drawSprite(PicoGraphics& graphics, const SpriteAsset& sprite, int32_t x, int32_t y) {
+  auto frameBuffer = (uint8_t*)graphics.frame_buffer;
+  const Rect& clip = graphics.clip;
+  int32_t clipRight = clip.x + clip.w;
+  int32_t clipBottom = clip.y + clip.h;
+
+  const uint8_t* data = sprite.data;
+  for(int i = 0; i < sprite.spanCount; i++) {
+    int32_t py = y + data[0];
+    int32_t px = x + data[1];
+    int32_t remaining = data[2];
+    data += 3;
+
+    // Rows are in order, nothing further down can be visible
+    if(py >= clipBottom) break;
+    bool rowVisible = py >= clip.y;
+    uint8_t* row = frameBuffer + py * graphics.bounds.w;
+
+    while(remaining > 0) {
+      uint8_t packet = *data++;
+      int32_t length = (packet & PACKET_LENGTH_MASK) + 1;
+      bool fill = packet & PACKET_FILL;
+
+      if(rowVisible) {
+        int32_t x1 = px > clip.x ? px : clip.x;
+        int32_t x2 = px + length < clipRight ? px + length : clipRight;
+        if(x2 > x1) {
+          if(fill) {
+            memset(row + x1, data[0], x2 - x1);
+          } else {
+            memcpy(row + x1, data + (x1 - px), x2 - x1);
+          }
+        }
+      }
+
+      data += fill ? 1 : length;
+      px += length;
+      remaining -= length;
+    }
+  }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "types.hpp"
+
+// RGB332 sprite stored in flash as run-length encoded opaque spans, see
+// tools/spritegen.py for the encoding. Transparent pixels are never
+// stored and the spans decode straight into the framebuffer.
+struct SpriteAsset {
+  uint8_t width;
+  uint8_t height;
+  uint8_t transparent;
+  uint16_t spanCount;
+  const uint8_t* data;
+  uint32_t size;
+};
+
+// Draws into an RGB332 framebuffer, clipped to graphics.clip
+void drawSprite(PicoGraphics& graphics, const SpriteAsset& sprite, int32_t x, int32_t y);
@@ -0,0 +1,36 @@
+# Encodes every PNG in assets/ into a header for drawSprite(), see
+# tools/spritegen.py. assets/<name>.png becomes "assets/<name>.hpp"
+# declaring `static constexpr SpriteAsset <name>`, so adding an icon is
+# just dropping in the PNG.
+#
+#   include(sprite_assets.cmake)
+#   target_sprite_assets(<target>)
+
+find_package(Python3 REQUIRED COMPONENTS Interpreter)
+
+set(SPRITE_ASSETS_SOURCE_DIR ${CMAKE_CURRENT_LIST_DIR}/assets)
+set(SPRITE_ASSETS_BINARY_DIR ${CMAKE_CURRENT_BINARY_DIR}/generated)
+set(SPRITEGEN ${CMAKE_CURRENT_LIST_DIR}/tools/spritegen.py)
+
+file(GLOB SPRITE_ASSETS_PNGS CONFIGURE_DEPENDS ${SPRITE_ASSETS_SOURCE_DIR}/*.png)
+
+set(SPRITE_ASSETS_HEADERS "")
+foreach(PNG ${SPRITE_ASSETS_PNGS})
+    get_filename_component(SPRITE_NAME ${PNG} NAME_WE)
+    set(HEADER ${SPRITE_ASSETS_BINARY_DIR}/assets/${SPRITE_NAME}.hpp)
+    add_custom_command(
+        OUTPUT ${HEADER}
+        COMMAND ${CMAKE_COMMAND} -E make_directory ${SPRITE_ASSETS_BINARY_DIR}/assets
+        COMMAND ${Python3_EXECUTABLE} ${SPRITEGEN} ${PNG} ${HEADER}
+        DEPENDS ${PNG} ${SPRITEGEN}
+        COMMENT "Encoding sprite ${SPRITE_NAME}"
+    )
+    list(APPEND SPRITE_ASSETS_HEADERS ${HEADER})
+endforeach()
+
+add_custom_target(sprite_assets DEPENDS ${SPRITE_ASSETS_HEADERS})
+
+function(target_sprite_assets TARGET)
+    add_dependencies(${TARGET} sprite_assets)
+    target_include_directories(${TARGET} PRIVATE ${SPRITE_ASSETS_BINARY_DIR})
+endfunction()
@@ -1,79 +1,99 @@
 
 #include "state.hpp"
+#include "kvstore.hpp"
+#include "flash_backend.hpp"
+#include "metrics.hpp"
 
-#include "pico/flash.h"
-#include "hardware/flash.h"
 #include "pico/time.h"
 
-size_t firstUnusedByte = 0;
-int scanTime = 0;
-int lastError = 0;
+#include <string.h>
+
+Gauge settingsScanMetric("settings_scan", "us");
+Gauge settingsUsedMetric("settings_used", "B");
+Gauge flashErrorMetric("flash_error");
+
+PicoFlashBackend settingsFlash(SETTINGS_BEGIN_WRITE);
+KvStore settings(&settingsFlash, SETTINGS_SECTORS);
 
 // Initialize state with default values
 State currentState = State(ENVIRONMENT, CELSIUS);
+
+// The newest state nobody has written yet, and when it last changed
 State pendingState = State(ENVIRONMENT, CELSIUS);
+bool hasPendingState = false;
+uint32_t pendingSince = 0;
 
-static const size_t RANGE_SIZE = 0x100;
+static bool sameState(const State& a, const State& b) {
+  return memcmp(a.state, b.state, sizeof(a.state)) == 0;
+}
 
-static void saveState(void* param) {
-    uint8_t data[RANGE_SIZE];
-    for(size_t i = 0; i < RANGE_SIZE; i++)
-    {
-        data[i] = 0xFF;
-    }
+void saveStateLater(State newState, uint32_t nowMs) {
+  if(hasPendingState && sameState(newState, pendingState)) return;
 
-    // Reached the end of the available EEPROM PAGE need to erase it
-    if(firstUnusedByte >= PAGE_SIZE) {
-        firstUnusedByte = 0;
-        flash_range_erase(STATE_BEGIN_WRITE, 4096);
-    }
-    
-    size_t flashOffset = firstUnusedByte - firstUnusedByte % RANGE_SIZE;
-    size_t stateOffsetInRange = firstUnusedByte % RANGE_SIZE;
+  // Toggling back to what's already in flash cancels the write altogether
+  hasPendingState = !sameState(newState, currentState);
+  pendingState = newState;
+  pendingSince = nowMs;
+}
 
-    for(size_t i = 0; i < stateOffsetInRange; i++) {
-        data[i] = 0x00;
-    }
+bool isStateCommitDue(uint32_t nowMs) {
+  return hasPendingState && nowMs - pendingSince >= STATE_SETTLE_MS;
+}
 
-    data[stateOffsetInRange] = pendingState.state[0];
-    data[stateOffsetInRange+1] = pendingState.state[1];
-    data[stateOffsetInRange+2] = pendingState.state[2];
-    data[stateOffsetInRange+3] = pendingState.state[3];
+bool isStateCommitOverdue(uint32_t nowMs) {
+  return hasPendingState && nowMs - pendingSince >= STATE_SETTLE_MS + STATE_IDLE_WAIT_MS;
+}
 
-    firstUnusedByte += 4;
-    
-    flash_range_program(STATE_BEGIN_WRITE + flashOffset, data, RANGE_SIZE);
+void commitState() {
+  if(!hasPendingState) return;
+
+  settings.put(SETTINGS_KEY_STATE, pendingState.state, sizeof(pendingState.state));
+  flashErrorMetric.set(settingsFlash.lastError);
+  settingsUsedMetric.set(settings.usedBytes());
+  currentState = pendingState;
+  hasPendingState = false;
 }
 
-void saveStateIfNeeded(State newState) {
-  if(newState.state[0] != currentState.state[0] ||
-    newState.state[1] != currentState.state[1] ||
-    newState.state[2] != currentState.state[2] ||
-    newState.state[3] != currentState.state[3] 
-  )
-  {
-    pendingState = newState;
-    lastError = flash_safe_execute(saveState, NULL, 500);
-    currentState = pendingState;
+// Before the KV store the state was a run of 4 byte slots in the last
+// sector, the newest just before the first erased one
+static bool loadLegacyState(State& state) {
+  const uint8_t* begin = settingsFlash.read(STATE_BEGIN_WRITE - SETTINGS_BEGIN_WRITE);
+  const uint8_t* end = begin + PAGE_SIZE;
+  const uint8_t* ptr = begin;
+  while(ptr < end && *ptr != 0xFF) {
+    ptr += 4;
   }
+  if(ptr == begin || !(ptr[-4] & USED_SLOT)) return false;
+
+  state = State((uint8_t*)ptr - 4);
+  return true;
 }
 
 State loadState() {
   auto scan_start = get_absolute_time();
-  uint8_t* ptr = (uint8_t*)STATE_BEGIN_READ;
-  while(*ptr != 0xFF && ptr < STATE_END_READ) {
-    ptr += 4;
+
+  // A first boot with the store carries over whatever the old format had
+  if(!settings.mount()) {
+    State legacy = State(ENVIRONMENT, CELSIUS);
+    bool hasLegacy = loadLegacyState(legacy);
+    settings.format();
+    if(hasLegacy) {
+      settings.put(SETTINGS_KEY_STATE, legacy.state, sizeof(legacy.state));
+    }
   }
-  
-  firstUnusedByte = ptr - STATE_BEGIN_READ;
 
-  // Move back one slot to find the valid data
-  ptr -= 4;
+  uint8_t data[sizeof(currentState.state)];
+  if(settings.get(SETTINGS_KEY_STATE, data, sizeof(data)) == sizeof(data)) {
+    currentState = State(data);
+  }
+
+  settingsUsedMetric.set(settings.usedBytes());
+  flashErrorMetric.set(settingsFlash.lastError);
 
   auto scan_end = get_absolute_time();
-  scanTime = absolute_time_diff_us(scan_start, scan_end);
-  
-  return State(ptr);
+  settingsScanMetric.set(absolute_time_diff_us(scan_start, scan_end));
+
+  return currentState;
 }
 
 State::State(MODE mode, UNIT units)
@@ -50,14 +50,16 @@ enum SAVED_STATE_FLAGS
 static const size_t EEPROM_SIZE = 0x200000; // 2Mb
 static const size_t PAGE_SIZE = 0x1000; // 4Kb
 
-static const uint8_t* STATE_BEGIN_READ = (uint8_t*)(XIP_BASE + EEPROM_SIZE - PAGE_SIZE);
-static const uint8_t* STATE_END_READ = (uint8_t*)(XIP_BASE + EEPROM_SIZE);
-
 static const size_t STATE_BEGIN_WRITE = EEPROM_SIZE - PAGE_SIZE;
 
-extern size_t firstUnusedByte;
-extern int scanTime;
-extern int lastError;
+// Settings live in a KV store over the last few sectors, which takes in
+// the single sector the state used to have to itself
+static const size_t SETTINGS_SECTORS = 4;
+static const size_t SETTINGS_BEGIN_WRITE = EEPROM_SIZE - SETTINGS_SECTORS * PAGE_SIZE;
+
+enum SETTINGS_KEY {
+  SETTINGS_KEY_STATE = 1,
+};
 
 struct State {
     uint8_t state[4];
@@ -69,5 +71,18 @@ struct State {
     MODE getMode();
 };
 
-void saveStateIfNeeded(State state);
+// A change has to sit still this long before it's written, so flicking
+// through modes or units costs one write instead of one per press
+static const uint32_t STATE_SETTLE_MS = 2000;
+// How long a settled change waits for the display to go idle by itself
+// before the caller should make it wait
+static const uint32_t STATE_IDLE_WAIT_MS = 1000;
+
+// Remembers the state to save, nothing touches flash until commitState
+void saveStateLater(State state, uint32_t nowMs);
+bool isStateCommitDue(uint32_t nowMs);
+bool isStateCommitOverdue(uint32_t nowMs);
+// Writes the pending state. Both cores stall while flash is busy, so only
+// call this with nothing on its way to the display.
+void commitState();
 State loadState();
\ No newline at end of file
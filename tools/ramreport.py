@@ -0,0 +1,168 @@
+#!/usr/bin/env python3
+"""Summarises RAM and flash use from the linker's map file.
+
+    ramreport.py build/jimneyio.elf.map
+    ramreport.py build/jimneyio.elf.map --top 30 -o jimneyio.ram.txt
+
+Prints how full each memory region is, what each output section in RAM
+costs, and the biggest input sections in RAM and in flash along with the
+object they came from. The heap and both stacks are sized by the linker
+script, the framebuffers come out of the heap at boot, so they show up in
+the stats overlay rather than here.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+REGION = re.compile(r"^(\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+SECTION = re.compile(r"^(\.\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+))?")
+INPUT = re.compile(r"^ (\S+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$")
+CONTINUATION = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(\S.*))?$")
+
+# Output sections that only reserve space, filled in at run time
+RESERVED = {".heap": "heap", ".stack_dummy": "core0 stack", ".stack1_dummy": "core1 stack"}
+
+
+def parse(lines):
+    """Returns (regions, sections, inputs). Regions are (name, origin,
+    length), sections (name, address, size) and inputs (section, name,
+    address, size, object)."""
+    regions = []
+    sections = []
+    inputs = []
+
+    lines = iter(lines)
+    for line in lines:
+        if line.startswith("Memory Configuration"):
+            break
+    for line in lines:
+        if line.startswith("Linker script and memory map"):
+            break
+        m = REGION.match(line)
+        if m and m.group(1) != "Name":
+            regions.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16)))
+
+    section = None
+    pending = None
+    for line in lines:
+        line = line.rstrip("\n")
+
+        # Long names put the address and size on the next line
+        if pending:
+            m = CONTINUATION.match(line)
+            kind, name = pending
+            pending = None
+            if m:
+                address, size = int(m.group(1), 16), int(m.group(2), 16)
+                if kind == "section":
+                    section = name
+                    sections.append((name, address, size))
+                elif size and m.group(3):
+                    inputs.append((section, name, address, size, m.group(3)))
+                continue
+
+        if line.startswith("."):
+            m = SECTION.match(line)
+            if m.group(2) is None:
+                pending = ("section", m.group(1))
+            else:
+                section = m.group(1)
+                sections.append((section, int(m.group(2), 16), int(m.group(3), 16)))
+        elif line.startswith(" .") or line.startswith(" COMMON"):
+            m = INPUT.match(line)
+            if not m:
+                continue
+            if m.group(2) is None:
+                pending = ("input", m.group(1))
+            else:
+                size = int(m.group(3), 16)
+                if size:
+                    inputs.append((section, m.group(1), int(m.group(2), 16), size, m.group(4)))
+
+    return regions, sections, inputs
+
+
+def region_of(regions, address):
+    for name, origin, length in regions:
+        if origin <= address < origin + length:
+            return name
+    return None
+
+
+def is_flash(name):
+    return name is not None and name.upper().startswith("FLASH")
+
+
+def short_object(path):
+    # "libfoo.a(bar.o)" and CMake's "CMakeFiles/x.dir/bar.cpp.obj"
+    m = re.search(r"\(([^)]+)\)$", path)
+    if m:
+        return "%s(%s)" % (os.path.basename(path[:m.start()]), m.group(1))
+    return os.path.basename(path)
+
+
+def report(regions, sections, inputs, top):
+    used = {}
+    reserved = {}
+    for name, address, size in sections:
+        region = region_of(regions, address)
+        if region and size:
+            totals = reserved if name in RESERVED else used
+            totals[region] = totals.get(region, 0) + size
+
+    # The heap takes whatever RAM is left, so reserved space is shown apart
+    print("Memory regions")
+    for name, origin, length in regions:
+        if name == "*default*":
+            continue
+        n = used.get(name, 0)
+        print("  %-10s %8d static %8d reserved / %8d bytes, %5.1f%% static" % (
+            name, n, reserved.get(name, 0), length, 100.0 * n / length if length else 0))
+
+    print("\nRAM by section")
+    for name, address, size in sections:
+        region = region_of(regions, address)
+        if size and region and not is_flash(region):
+            note = RESERVED.get(name, "")
+            print("  %-20s %-10s %8d bytes  %s" % (name, region, size, note))
+
+    ram = [i for i in inputs if not is_flash(region_of(regions, i[2])) and i[0] not in RESERVED]
+    flash = [i for i in inputs if is_flash(region_of(regions, i[2]))]
+
+    for title, items in (("RAM", ram), ("flash", flash)):
+        items = sorted(items, key=lambda i: -i[3])
+        print("\nLargest in %s" % title)
+        for section, name, address, size, obj in items[:top]:
+            print("  %8d  %-48s %s" % (size, name[:48], short_object(obj)))
+
+    by_object = {}
+    for section, name, address, size, obj in ram:
+        by_object[short_object(obj)] = by_object.get(short_object(obj), 0) + size
+    print("\nRAM by object")
+    for obj, size in sorted(by_object.items(), key=lambda o: -o[1])[:top]:
+        print("  %8d  %s" % (size, obj))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("map")
+    parser.add_argument("--top", type=int, default=15, help="how many of the largest sections to list")
+    parser.add_argument("-o", "--output", help="write the report here instead of stdout")
+    args = parser.parse_args()
+
+    with open(args.map) as f:
+        regions, sections, inputs = parse(f)
+    if not sections:
+        sys.exit("%s: no sections, is it a GNU ld map file?" % args.map)
+
+    if args.output:
+        with open(args.output, "w") as sys.stdout:
+            report(regions, sections, inputs, args.top)
+    else:
+        report(regions, sections, inputs, args.top)
+
+
+if __name__ == "__main__":
+    main()
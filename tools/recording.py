@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""Captures, prints and embeds sensor recordings (see recording.hpp).
+
+    recording.py capture trail.jrec < /dev/ttyACM0
+    recording.py dump trail.jrec
+    recording.py embed trail.jrec replay_data.hpp
+    recording.py synth drive.jrec
+
+capture keeps the "REC <hex>" lines a JIMNEYIO_RECORD build prints over USB
+serial and writes them out as a binary .jrec, ignoring any other output.
+embed turns a recording into a header declaring REPLAY_DATA, for
+JIMNEYIO_REPLAY_FILE builds. synth writes a made-up minute of driving
+that visits every screen, the same bytes every time, for checking replays
+without a Pico.
+"""
+
+import argparse
+import math
+import struct
+import sys
+
+MAGIC = b"JREC"
+VERSION = 1
+HEADER_SIZE = 8
+RECORD_HEADER_SIZE = 6
+
+RECORD_ENVIRONMENT = 1
+RECORD_ATTITUDE = 2
+RECORD_BUTTON = 3
+
+BUTTONS = "ABXY"
+
+MODE_ENVIRONMENT = 1
+UNITS_CELSIUS = 0
+
+
+def read_records(data):
+    if len(data) < HEADER_SIZE or data[:4] != MAGIC:
+        raise ValueError("not a recording")
+    if data[4] > VERSION:
+        raise ValueError("recording version %d is newer than this tool" % data[4])
+
+    offset = HEADER_SIZE
+    while offset + RECORD_HEADER_SIZE <= len(data):
+        time_ms, kind, length = struct.unpack_from("<IBB", data, offset)
+        payload = data[offset + RECORD_HEADER_SIZE:offset + RECORD_HEADER_SIZE + length]
+        if len(payload) < length:
+            break
+        offset += RECORD_HEADER_SIZE + length
+        yield time_ms, kind, payload
+
+
+def capture(args):
+    data = bytearray()
+    for line in sys.stdin.buffer:
+        line = line.strip()
+        if not line.startswith(b"REC "):
+            continue
+        try:
+            data += bytes.fromhex(line[4:].decode("ascii"))
+        except ValueError:
+            print("skipping corrupt line", file=sys.stderr)
+
+    with open(args.recording, "wb") as f:
+        f.write(data)
+
+
+def dump(args):
+    with open(args.recording, "rb") as f:
+        data = f.read()
+
+    for time_ms, kind, payload in read_records(data):
+        if kind == RECORD_ENVIRONMENT and len(payload) >= 17:
+            t, p, h, g, stable = struct.unpack_from("<ffffB", payload)
+            print("%10.3f env %.2fC %.0fPa %.1f%% %.0fohm%s" % (time_ms / 1000, t, p, h, g, "" if stable else " heating"))
+        elif kind == RECORD_ATTITUDE and len(payload) >= 4:
+            pitch, roll = struct.unpack_from("<hh", payload)
+            print("%10.3f attitude pitch %.1f roll %.1f" % (time_ms / 1000, pitch * 360 / 65536, roll * 360 / 65536))
+        elif kind == RECORD_BUTTON and len(payload) >= 1 and payload[0] < len(BUTTONS):
+            print("%10.3f button %s" % (time_ms / 1000, BUTTONS[payload[0]]))
+        else:
+            print("%10.3f unknown type %d, %d bytes" % (time_ms / 1000, kind, len(payload)))
+
+
+def embed(args):
+    with open(args.recording, "rb") as f:
+        data = f.read()
+    list(read_records(data))
+
+    with open(args.header, "w") as f:
+        f.write("// Generated by tools/recording.py from %s, do not edit\n" % args.recording)
+        f.write("#pragma once\n\n#include <stdint.h>\n\n")
+        f.write("static const uint8_t REPLAY_DATA[%d] = {\n" % len(data))
+        for i in range(0, len(data), 16):
+            f.write("  " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",\n")
+        f.write("};\n")
+
+
+def synth(args):
+    records = []
+
+    def record(time_ms, kind, payload):
+        records.append((time_ms, kind, payload))
+
+    # Warming up over the minute, the heater settles after a few samples
+    for second in range(60):
+        t = 20.0 + second * 0.1
+        record(second * 1000, RECORD_ENVIRONMENT,
+               struct.pack("<ffffB", t, 101325.0 - second * 5, 45.0 + second % 7, 50000.0, second >= 5))
+
+    # Rocking back and forth at 25Hz, a bit over the scale of a green lane
+    for i in range(60 * 25):
+        seconds = i / 25
+        pitch = 15 * math.sin(seconds * 0.7)
+        roll = 25 * math.sin(seconds * 1.3)
+        record(i * 40, RECORD_ATTITUDE,
+               struct.pack("<hh", int(round(pitch * 65536 / 360)), int(round(roll * 65536 / 360))))
+
+    # Fahrenheit, the inclinometer, then back to the environment in Celsius
+    for time_ms, button in ((10000, "A"), (20000, "B"), (45000, "A"), (50000, "A")):
+        record(time_ms, RECORD_BUTTON, bytes([BUTTONS.index(button)]))
+
+    data = bytearray(MAGIC + bytes([VERSION, MODE_ENVIRONMENT, UNITS_CELSIUS, 0]))
+    for time_ms, kind, payload in sorted(records, key=lambda r: (r[0], r[1])):
+        data += struct.pack("<IBB", time_ms, kind, len(payload)) + payload
+
+    with open(args.recording, "wb") as f:
+        f.write(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    p = commands.add_parser("capture", help="serial output on stdin to a .jrec")
+    p.add_argument("recording")
+    p.set_defaults(run=capture)
+
+    p = commands.add_parser("dump", help="print every record")
+    p.add_argument("recording")
+    p.set_defaults(run=dump)
+
+    p = commands.add_parser("embed", help="write a header for a replay build")
+    p.add_argument("recording")
+    p.add_argument("header")
+    p.set_defaults(run=embed)
+
+    p = commands.add_parser("synth", help="write a made-up drive through every screen")
+    p.add_argument("recording")
+    p.set_defaults(run=synth)
+
+    args = parser.parse_args()
+    try:
+        args.run(args)
+    except ValueError as e:
+        sys.exit("%s: %s" % (args.recording, e))
+
+
+if __name__ == "__main__":
+    main()
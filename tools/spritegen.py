@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+"""Encodes PNG sprites into the run-length span format drawn by drawSprite().
+
+    spritegen.py assets/jimny_dark.png jimny_dark.hpp
+
+Colours are truncated to RGB332 the same way PicoGraphics create_pen() does.
+Pixels with alpha below 128 are transparent. Opaque PNGs can name a colour
+key with --transparent instead.
+
+Each opaque run is stored as y, x, length followed by packets that together
+cover length pixels:
+
+    1nnnnnnn c        fill n+1 pixels with colour c
+    0nnnnnnn p...     copy the n+1 literal pixels that follow
+
+Transparent pixels are never stored.
+"""
+
+import argparse
+import os
+import struct
+import sys
+import zlib
+
+MAX_PACKET = 128
+
+# Repeats shorter than this are cheaper as part of a literal packet
+MIN_FILL = 3
+
+
+PNG_SIGNATURE = b"\x89PNG\r\n\x1a\n"
+
+# Channels per pixel for each 8 bit PNG colour type
+PNG_CHANNELS = {0: 1, 2: 3, 3: 1, 4: 2, 6: 4}
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def unfilter(data, width, height, bpp):
+    stride = width * bpp
+    rows = []
+    prev = bytearray(stride)
+    pos = 0
+    for _ in range(height):
+        kind = data[pos]
+        row = bytearray(data[pos + 1:pos + 1 + stride])
+        pos += 1 + stride
+
+        for i in range(stride):
+            left = row[i - bpp] if i >= bpp else 0
+            up = prev[i]
+            up_left = prev[i - bpp] if i >= bpp else 0
+            if kind == 1:
+                row[i] = (row[i] + left) & 0xFF
+            elif kind == 2:
+                row[i] = (row[i] + up) & 0xFF
+            elif kind == 3:
+                row[i] = (row[i] + ((left + up) >> 1)) & 0xFF
+            elif kind == 4:
+                row[i] = (row[i] + paeth(left, up, up_left)) & 0xFF
+
+        rows.append(row)
+        prev = row
+    return rows
+
+
+def read_png(path):
+    """Returns width, height and a flat list of (r, g, b, a) pixels."""
+    with open(path, "rb") as f:
+        blob = f.read()
+    if not blob.startswith(PNG_SIGNATURE):
+        sys.exit("%s: not a PNG" % path)
+
+    pos = len(PNG_SIGNATURE)
+    idat = b""
+    palette = []
+    alpha = []
+    while pos < len(blob):
+        length, kind = struct.unpack(">I4s", blob[pos:pos + 8])
+        body = blob[pos + 8:pos + 8 + length]
+        pos += 12 + length
+
+        if kind == b"IHDR":
+            width, height, depth, colour, _, _, interlace = struct.unpack(">IIBBBBB", body)
+        elif kind == b"PLTE":
+            palette = [tuple(body[i:i + 3]) for i in range(0, len(body), 3)]
+        elif kind == b"tRNS":
+            alpha = list(body)
+        elif kind == b"IDAT":
+            idat += body
+        elif kind == b"IEND":
+            break
+
+    if depth != 8 or colour not in PNG_CHANNELS or interlace:
+        sys.exit("%s: only non-interlaced 8 bit PNGs are supported" % path)
+
+    channels = PNG_CHANNELS[colour]
+    pixels = []
+    for row in unfilter(zlib.decompress(idat), width, height, channels):
+        for x in range(width):
+            p = row[x * channels:(x + 1) * channels]
+            if colour == 0:
+                pixels.append((p[0], p[0], p[0], 255))
+            elif colour == 2:
+                pixels.append((p[0], p[1], p[2], 255))
+            elif colour == 3:
+                a = alpha[p[0]] if p[0] < len(alpha) else 255
+                pixels.append(palette[p[0]] + (a,))
+            elif colour == 4:
+                pixels.append((p[0], p[0], p[0], p[1]))
+            else:
+                pixels.append(tuple(p))
+    return width, height, pixels
+
+
+def to_rgb332(r, g, b):
+    return (r & 0b11100000) | ((g & 0b11100000) >> 3) | (b >> 6)
+
+
+def quantize(pixels, transparent):
+    """Maps pixels to RGB332 and picks a transparency key none of the opaque
+    pixels use, preferring the colour the transparent pixels were drawn in."""
+    opaque = set()
+    hidden = set()
+    out = []
+    for r, g, b, a in pixels:
+        c = to_rgb332(r, g, b)
+        if a < 128 or c == transparent:
+            hidden.add(c)
+            out.append(None)
+        else:
+            opaque.add(c)
+            out.append(c)
+
+    if transparent is None:
+        candidates = sorted(hidden) + list(range(256))
+        transparent = next((c for c in candidates if c not in opaque), None)
+        if transparent is None:
+            sys.exit("sprite uses all 256 RGB332 colours, no transparency key is free")
+
+    return [transparent if c is None else c for c in out], transparent
+
+
+def encode_run(pixels):
+    out = []
+    literal = []
+
+    def flush():
+        while literal:
+            n = min(len(literal), MAX_PACKET)
+            out.append(n - 1)
+            out.extend(literal[:n])
+            del literal[:n]
+
+    i = 0
+    while i < len(pixels):
+        j = i
+        while j < len(pixels) and pixels[j] == pixels[i]:
+            j += 1
+
+        if j - i >= MIN_FILL:
+            flush()
+            n = j - i
+            while n > 0:
+                k = min(n, MAX_PACKET)
+                out.append(0x80 | (k - 1))
+                out.append(pixels[i])
+                n -= k
+        else:
+            literal.extend(pixels[i:j])
+        i = j
+
+    flush()
+    return out
+
+
+def encode(pixels, width, height, transparent):
+    data = []
+    spans = 0
+    for y in range(height):
+        row = pixels[y * width:(y + 1) * width]
+        x = 0
+        while x < width:
+            if row[x] == transparent:
+                x += 1
+                continue
+
+            start = x
+            while x < width and row[x] != transparent:
+                x += 1
+
+            data.extend((y, start, x - start))
+            data.extend(encode_run(row[start:x]))
+            spans += 1
+
+    return data, spans
+
+
+def write_header(path, name, source, width, height, transparent, data, spans):
+    lines = [
+        "// Generated by tools/spritegen.py from %s, do not edit" % source,
+        "#pragma once",
+        "",
+        '#include "sprite.hpp"',
+        "",
+        "static const uint8_t %s_data[] = {" % name,
+    ]
+    for i in range(0, len(data), 16):
+        lines.append("  " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    lines += [
+        "};",
+        "",
+        "static constexpr SpriteAsset %s = {" % name,
+        "  %d, %d, 0x%02x, %d, %s_data, sizeof(%s_data)" % (width, height, transparent, spans, name, name),
+        "};",
+        "",
+    ]
+
+    with open(path, "w") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--name", help="C identifier for the asset, defaults to the file name")
+    parser.add_argument("--transparent", type=lambda v: int(v, 0), help="RGB332 colour key for opaque PNGs")
+    parser.add_argument("input", help="PNG image")
+    parser.add_argument("output", help="header to write")
+    args = parser.parse_args()
+
+    name = args.name or os.path.splitext(os.path.basename(args.input))[0]
+    width, height, rgba = read_png(args.input)
+    if width > 255 or height > 255:
+        sys.exit("%s: sprites are limited to 255x255" % args.input)
+
+    pixels, transparent = quantize(rgba, args.transparent)
+    data, spans = encode(pixels, width, height, transparent)
+    write_header(args.output, name, os.path.basename(args.input), width, height, transparent, data, spans)
+
+
+if __name__ == "__main__":
+    main()
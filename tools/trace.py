@@ -0,0 +1,227 @@
+#!/usr/bin/env python3
+"""Captures and decodes frame timeline traces (see trace.hpp).
+
+    trace.py capture run.jtrace < /dev/ttyACM0
+    trace.py timeline run.jtrace > run.json
+    trace.py stats run.jtrace
+
+capture keeps the "TRC <hex>" lines a JIMNEYIO_TRACE build prints over USB
+serial and writes the events out as a binary .jtrace, ignoring any other
+output. timeline writes Chrome trace JSON, open it in ui.perfetto.dev or
+chrome://tracing to see both cores side by side. stats prints latency
+histograms for each stage and the slowest frames broken down by stage.
+"""
+
+import argparse
+import bisect
+import json
+import struct
+import sys
+
+EVENT = struct.Struct("<IBBH")
+
+TRACE_END = 0x01
+TRACE_CORE1 = 0x02
+TRACE_DROPPED = 0xFF
+
+STAGES = ["input", "sensor_read", "render", "buffer_wait", "flash_save", "display_update"]
+
+
+def stage_name(stage):
+    return STAGES[stage] if stage < len(STAGES) else "stage_%d" % stage
+
+
+def read_events(data):
+    """Yields (time_us, core, stage, end, frame), with the 32 bit timer
+    unwrapped. The cores arrive in batches so time can step back a little,
+    anything within half the timer's range counts as a small step."""
+    last = None
+    base = 0
+    for offset in range(0, len(data) - EVENT.size + 1, EVENT.size):
+        time_us, stage, flags, frame = EVENT.unpack_from(data, offset)
+        if last is None:
+            base = time_us
+        else:
+            step = (time_us - last) & 0xFFFFFFFF
+            if step >= 0x80000000:
+                step -= 0x100000000
+            base += step
+        last = time_us
+        yield base, 1 if flags & TRACE_CORE1 else 0, stage, bool(flags & TRACE_END), frame
+
+
+def read_spans(data):
+    """Pairs begins with ends, nesting per core and stage, and returns
+    (spans, drops). Spans are (start_us, end_us, core, stage, frame)."""
+    open_spans = {}
+    spans = []
+    drops = []
+    start = None
+    for time_us, core, stage, end, frame in read_events(data):
+        if start is None:
+            start = time_us
+        if stage == TRACE_DROPPED:
+            drops.append((time_us - start, core, frame))
+            continue
+
+        stack = open_spans.setdefault((core, stage), [])
+        if not end:
+            stack.append((time_us, frame))
+        elif stack:
+            begin_us, begin_frame = stack.pop()
+            spans.append((begin_us - start, time_us - start, core, stage, begin_frame))
+
+    spans.sort()
+    return spans, drops
+
+
+def read_trace(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) % EVENT.size:
+        print("%s: ignoring %d trailing bytes" % (path, len(data) % EVENT.size), file=sys.stderr)
+    return read_spans(data)
+
+
+def capture(args):
+    data = bytearray()
+    for line in sys.stdin.buffer:
+        line = line.strip()
+        if not line.startswith(b"TRC "):
+            continue
+        try:
+            events = bytes.fromhex(line[4:].decode("ascii"))
+        except ValueError:
+            print("skipping corrupt line", file=sys.stderr)
+            continue
+        if len(events) % EVENT.size:
+            print("skipping truncated line", file=sys.stderr)
+            continue
+        data += events
+
+    with open(args.trace, "wb") as f:
+        f.write(data)
+
+
+def timeline(args):
+    spans, drops = read_trace(args.trace)
+
+    events = []
+    for core in (0, 1):
+        events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": core, "args": {"name": "core%d" % core}})
+    for start, end, core, stage, frame in spans:
+        events.append({"name": stage_name(stage), "ph": "X", "ts": start, "dur": end - start,
+                       "pid": 0, "tid": core, "args": {"frame": frame}})
+    for time_us, core, count in drops:
+        events.append({"name": "dropped %d" % count, "ph": "i", "s": "t", "ts": time_us, "pid": 0, "tid": core})
+
+    json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, sys.stdout)
+    sys.stdout.write("\n")
+
+
+def percentile(values, p):
+    return values[min(len(values) - 1, int(len(values) * p / 100))]
+
+
+def histogram(values):
+    """Counts per power of two bucket of microseconds, [(low, high, count)]"""
+    buckets = {}
+    for v in values:
+        bucket = max(v, 1).bit_length() - 1
+        buckets[bucket] = buckets.get(bucket, 0) + 1
+    return [(1 << b if b else 0, (1 << (b + 1)) - 1, buckets.get(b, 0))
+            for b in range(min(buckets), max(buckets) + 1)]
+
+
+def stats(args):
+    spans, drops = read_trace(args.trace)
+    if not spans:
+        sys.exit("%s: no complete spans" % args.trace)
+
+    by_stage = {}
+    for start, end, core, stage, frame in spans:
+        by_stage.setdefault((stage, core), []).append(end - start)
+
+    for (stage, core), durations in sorted(by_stage.items()):
+        durations.sort()
+        print("%s core%d: %d spans, min %dus p50 %dus p90 %dus p99 %dus max %dus" % (
+            stage_name(stage), core, len(durations), durations[0], percentile(durations, 50),
+            percentile(durations, 90), percentile(durations, 99), durations[-1]))
+
+        rows = histogram(durations)
+        widest = max(count for _, _, count in rows)
+        for low, high, count in rows:
+            bar = "#" * (count * 40 // widest) if count else ""
+            print("  %7d-%-7d us %7d %s" % (low, high, count, bar))
+        print()
+
+    if drops:
+        print("%d events dropped by full rings\n" % sum(count for _, _, count in drops))
+
+    frames = slowest_frames(spans)
+    if frames:
+        print("slowest frames, input to display:")
+        for f in frames[:args.top]:
+            breakdown = ", ".join("%s %dus" % (stage_name(s), d) for s, d in sorted(f["stages"].items()))
+            print("  frame %5d at %9.3fs: %6dus (%s)" % (f["number"], f["start"] / 1e6, f["end"] - f["start"], breakdown))
+
+
+def slowest_frames(spans):
+    """Frames that were both rendered and sent, slowest first. A frame runs
+    from its input to the end of its display update."""
+    SENSOR_READ, RENDER, DISPLAY_UPDATE = 1, 2, 5
+
+    # Frame numbers wrap at 65536, a long trace reuses them
+    frames = []
+    active = {}
+    for start, end, core, stage, frame in spans:
+        if stage == SENSOR_READ:
+            continue
+        f = active.get(frame)
+        if f is None or start - f["start"] > 60 * 1000 * 1000:
+            f = {"number": frame, "start": start, "end": end, "stages": {}}
+            active[frame] = f
+            frames.append(f)
+        f["end"] = max(f["end"], end)
+        f["stages"][stage] = f["stages"].get(stage, 0) + end - start
+
+    # Sensor reads run from interrupts, so charge them to whichever frames
+    # they interrupted
+    frames.sort(key=lambda f: f["start"])
+    starts = [f["start"] for f in frames]
+    for start, end, core, stage, frame in spans:
+        if stage != SENSOR_READ:
+            continue
+        i = bisect.bisect_right(starts, start)
+        for f in frames[max(0, i - 4):i]:
+            if f["end"] > start:
+                f["stages"][stage] = f["stages"].get(stage, 0) + end - start
+
+    complete = [f for f in frames if RENDER in f["stages"] and DISPLAY_UPDATE in f["stages"]]
+    complete.sort(key=lambda f: f["start"] - f["end"])
+    return complete
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    p = commands.add_parser("capture", help="serial output on stdin to a .jtrace")
+    p.add_argument("trace")
+    p.set_defaults(run=capture)
+
+    p = commands.add_parser("timeline", help="Chrome trace JSON on stdout")
+    p.add_argument("trace")
+    p.set_defaults(run=timeline)
+
+    p = commands.add_parser("stats", help="per stage histograms and the slowest frames")
+    p.add_argument("trace")
+    p.add_argument("--top", type=int, default=10, help="how many of the slowest frames to show")
+    p.set_defaults(run=stats)
+
+    args = parser.parse_args()
+    args.run(args)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,63 @@
+#include "trace.hpp"
+#include "spsc_queue.hpp"
+
+#include "pico/time.h"
+#include "hardware/sync.h"
+#include "hardware/structs/sio.h"
+
+// A few frames' worth per core at a full drain every loop
+static const size_t TRACE_RING_SIZE = 256;
+
+// Each ring's producer is its own core, thread or interrupt, and core0 is
+// the only consumer
+static SpscQueue<TraceEvent, TRACE_RING_SIZE> traceRings[2];
+
+// Only ever counted up by the core that owns the ring, so core0 can read
+// core1's without a lock
+static volatile uint32_t droppedEvents[2];
+static uint32_t reportedDrops[2];
+
+void traceEvent(TRACE_STAGE stage, bool end, uint16_t frame) {
+  uint32_t core = sio_hw->cpuid;
+  TraceEvent event = {
+    time_us_32(),
+    (uint8_t)stage,
+    (uint8_t)((end ? TRACE_END : 0) | (core ? TRACE_CORE1 : 0)),
+    frame
+  };
+
+  // An interrupt tracing on the same core would be a second producer
+  uint32_t interrupts = save_and_disable_interrupts();
+  if(!traceRings[core].push(event)) {
+    droppedEvents[core]++;
+  }
+  restore_interrupts(interrupts);
+}
+
+void drainTrace(TraceSink sink, size_t maxEvents) {
+  TraceEvent events[32];
+
+  for(uint32_t core = 0; core < 2; core++) {
+    size_t count = 0;
+
+    // Losses are reported where they happened in the stream
+    uint32_t dropped = droppedEvents[core] - reportedDrops[core];
+    reportedDrops[core] += dropped;
+    if(dropped > 0) {
+      events[count++] = {time_us_32(), TRACE_DROPPED, (uint8_t)(core ? TRACE_CORE1 : 0), (uint16_t)(dropped > 0xFFFF ? 0xFFFF : dropped)};
+    }
+
+    for(size_t sent = 0; sent < maxEvents && traceRings[core].pop(events[count]);) {
+      count++;
+      sent++;
+      if(count == sizeof(events) / sizeof(events[0])) {
+        sink((const uint8_t*)events, count * sizeof(TraceEvent));
+        count = 0;
+      }
+    }
+
+    if(count > 0) {
+      sink((const uint8_t*)events, count * sizeof(TraceEvent));
+    }
+  }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Frame timeline tracing. Each core logs begin and end events for the
+// stages of a frame into its own ring, and core0 drains both over USB
+// serial for tools/trace.py. Events are 8 bytes, little endian:
+//
+//   event  timeUs(4) stage(1) flags(1) frame(2)
+//
+// timeUs is the low 32 bits of the shared microsecond timer. flags bit 0
+// marks an end, bit 1 is the core. frame ties the stages of one frame
+// together across the cores.
+//
+// Only built in with -DJIMNEYIO_TRACE=ON, otherwise the calls compile to
+// nothing.
+
+enum TRACE_STAGE {
+  TRACE_INPUT = 0,
+  TRACE_SENSOR_READ = 1,
+  TRACE_RENDER = 2,
+  TRACE_BUFFER_WAIT = 3,
+  TRACE_FLASH_SAVE = 4,
+  TRACE_DISPLAY_UPDATE = 5,
+  // Not a stage, frame holds how many events a full ring threw away
+  TRACE_DROPPED = 0xFF
+};
+
+static const uint8_t TRACE_END = 0x01;
+static const uint8_t TRACE_CORE1 = 0x02;
+
+struct TraceEvent {
+  uint32_t timeUs;
+  uint8_t stage;
+  uint8_t flags;
+  uint16_t frame;
+};
+
+static_assert(sizeof(TraceEvent) == 8, "trace events go out as they are in memory");
+
+typedef void (*TraceSink)(const uint8_t* data, size_t length);
+
+// Safe from either core and from interrupts. Drops the event if the
+// calling core's ring is full.
+void traceEvent(TRACE_STAGE stage, bool end, uint16_t frame);
+
+// Sends up to maxEvents from each core's ring, core0 only
+void drainTrace(TraceSink sink, size_t maxEvents);
+
+static inline void traceBegin(TRACE_STAGE stage, uint16_t frame = 0) {
+#if TRACE
+  traceEvent(stage, false, frame);
+#endif
+}
+
+static inline void traceEnd(TRACE_STAGE stage, uint16_t frame = 0) {
+#if TRACE
+  traceEvent(stage, true, frame);
+#endif
+}
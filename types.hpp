@@ -17,8 +17,6 @@ struct Pens {
   Pen WHITE;
   Pen YELLOW;
   Pen LIGHT_BLUE;
-  Pen SPRITE_TRANSPARENCY_LIGHT;
-  Pen SPRITE_TRANSPARENCY_DARK;
 
   Pen SKY_BLUE_DAY;
   Pen GRASS_GREEN_DAY;
@@ -51,4 +49,11 @@ enum MODE {
 enum UNIT {
   CELSIUS = 0,
   FAHRENHEIT = 1
+};
+
+enum BUTTON {
+  BUTTON_A = 0,
+  BUTTON_B = 1,
+  BUTTON_X = 2,
+  BUTTON_Y = 3
 };
\ No newline at end of file
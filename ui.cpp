@@ -0,0 +1,56 @@
+#include "ui.hpp"
+#include "splash.hpp"
+#include "environment.hpp"
+#include "inclinometer.hpp"
+
+void applyButtonPress(UiState& ui, BUTTON button) {
+  switch(button) {
+    case BUTTON_A:
+      if(ui.mode == ENVIRONMENT) {
+        ui.units = ui.units == CELSIUS ? FAHRENHEIT : CELSIUS;
+      }
+      ui.mode = ENVIRONMENT;
+      break;
+
+    case BUTTON_B:
+      ui.mode = INCLINOMETER;
+      break;
+
+    case BUTTON_X:
+      ui.statsEnabled = true;
+      break;
+
+    case BUTTON_Y:
+      ui.statsEnabled = false;
+      break;
+  }
+}
+
+void renderScreen(PicoGraphics& graphics, Pens& pens, const UiState& ui) {
+  updateScreen(ui);
+  drawScreen(graphics, pens, ui);
+}
+
+// The environment screen draws from the history, which only changes in
+// updateEnvironment between frames
+void updateScreen(const UiState& ui) {
+  if(ui.mode == INCLINOMETER) {
+    updateInclinometer();
+  }
+}
+
+void drawScreen(PicoGraphics& graphics, Pens& pens, const UiState& ui) {
+  switch(ui.mode) {
+    case SPLASH:
+      renderSplashFrame(graphics, pens);
+      break;
+
+    case ENVIRONMENT:
+      renderEnvironmentFrame(graphics, pens, ui.units);
+      break;
+
+    case INCLINOMETER:
+      drawInclinometerFrame(graphics, pens);
+      break;
+  }
+}
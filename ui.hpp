@@ -0,0 +1,27 @@
+#pragma once
+
+#include "types.hpp"
+
+// What's on screen and how, everything a button press can change
+struct UiState {
+  MODE mode = SPLASH;
+  UNIT units = CELSIUS;
+  bool statsEnabled = false;
+
+  bool operator==(const UiState& other) const {
+    return mode == other.mode && units == other.units && statsEnabled == other.statsEnabled;
+  }
+  bool operator!=(const UiState& other) const { return !(*this == other); }
+};
+
+void applyButtonPress(UiState& ui, BUTTON button);
+
+// Draws the current screen, without the stats overlay
+void renderScreen(PicoGraphics& graphics, Pens& pens, const UiState& ui);
+
+// renderScreen in two halves. The update takes whatever readings the
+// screen needs, once per frame. The draw only touches pixels inside the
+// graphics' clip and reads nothing that changes until the next update, so
+// each core can draw its own band of the same frame.
+void updateScreen(const UiState& ui);
+void drawScreen(PicoGraphics& graphics, Pens& pens, const UiState& ui);